@@ -0,0 +1,78 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#include "Asset_Loader.hpp"
+#include "Thread_Pool.hpp"
+#include "Trace.hpp"
+#include <chrono>
+
+namespace udit
+{
+    Asset_Loader& Asset_Loader::instance()
+    {
+        static Asset_Loader loader;
+        return loader;
+    }
+
+    void Asset_Loader::submit(Job job)
+    {
+        pending++;
+
+        Thread_Pool::instance().submit([this, job]
+        {
+            Upload upload = job();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                uploads.push_back(upload ? std::move(upload) : Upload([] {}));
+            }
+
+            upload_ready.notify_all();
+        });
+    }
+
+    size_t Asset_Loader::process_uploads(double budget_ms)
+    {
+        UDIT_TRACE_SCOPE("Asset_Loader::process_uploads");
+
+        using Clock = std::chrono::steady_clock;
+
+        auto   start     = Clock::now();
+        size_t processed = 0;
+
+        for (;;)
+        {
+            Upload upload;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (uploads.empty()) break;
+
+                upload = std::move(uploads.front());
+                uploads.pop_front();
+            }
+
+            // Una subida puede encolar nuevos trabajos; pending se descuenta después
+            upload();
+            pending--;
+            processed++;
+
+            if (std::chrono::duration<double, std::milli>(Clock::now() - start).count() >= budget_ms) break;
+        }
+
+        return processed;
+    }
+
+    void Asset_Loader::wait_all()
+    {
+        while (is_loading())
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                upload_ready.wait(lock, [this] { return !uploads.empty(); });
+            }
+
+            process_uploads(1e9);
+        }
+    }
+}
@@ -0,0 +1,53 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace udit
+{
+    // Carga de recursos en dos fases: el trabajo de CPU (lectura, decodificación,
+    // importación) corre en el Thread_Pool y devuelve la subida a la GPU, que se
+    // ejecuta después en el hilo de OpenGL desde process_uploads().
+    class Asset_Loader
+    {
+    public:
+
+        using Upload = std::function<void()>;
+        using Job    = std::function<Upload()>;
+
+    private:
+
+        std::mutex              mutex;
+        std::condition_variable upload_ready;
+        std::deque<Upload>      uploads;
+        std::atomic<unsigned>   pending;            // Trabajos cuya subida aún no ha corrido
+
+    public:
+
+        static Asset_Loader& instance();
+
+        // Lanza job en un hilo de trabajo; la subida que devuelva (puede ser vacía)
+        // se encola para el hilo de OpenGL
+        void submit(Job job);
+
+        // Ejecuta subidas terminadas hasta agotar el presupuesto (al menos una si hay).
+        // Solo desde el hilo de OpenGL. Devuelve cuántas se han ejecutado.
+        size_t process_uploads(double budget_ms);
+
+        // Procesa subidas hasta que no quede ningún trabajo en vuelo
+        void wait_all();
+
+        bool is_loading() const { return pending.load() != 0; }
+
+    private:
+
+        Asset_Loader() : pending(0) {}
+    };
+}
@@ -0,0 +1,69 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <glm.hpp>
+
+namespace udit
+{
+    // Caja alineada con los ejes. Una caja vacía tiene min > max.
+    struct Aabb
+    {
+        glm::vec3 min = glm::vec3( std::numeric_limits<float>::max());
+        glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+        bool is_empty() const { return min.x > max.x; }
+
+        void extend(const glm::vec3& point)
+        {
+            min = glm::min(min, point);
+            max = glm::max(max, point);
+        }
+
+        void extend(const Aabb& other)
+        {
+            if (other.is_empty()) return;
+            min = glm::min(min, other.min);
+            max = glm::max(max, other.max);
+        }
+
+        glm::vec3 get_center () const { return (min + max) * 0.5f; }
+        glm::vec3 get_extent () const { return (max - min) * 0.5f; }
+
+        // Caja que envuelve a esta caja transformada (centro/extensión, Arvo)
+        Aabb transformed(const glm::mat4& matrix) const
+        {
+            if (is_empty()) return *this;
+
+            glm::vec3 center = glm::vec3(matrix * glm::vec4(get_center(), 1.0f));
+            glm::vec3 extent = get_extent();
+
+            glm::vec3 world_extent =
+                glm::abs(glm::vec3(matrix[0])) * extent.x +
+                glm::abs(glm::vec3(matrix[1])) * extent.y +
+                glm::abs(glm::vec3(matrix[2])) * extent.z;
+
+            return Aabb{ center - world_extent, center + world_extent };
+        }
+    };
+
+    struct Sphere
+    {
+        glm::vec3 center = glm::vec3(0.0f);
+        float     radius = 0.0f;
+
+        // La escala no uniforme se cubre con el mayor factor de escala
+        Sphere transformed(const glm::mat4& matrix) const
+        {
+            float scale = std::sqrt(glm::max(glm::max(
+                glm::dot(glm::vec3(matrix[0]), glm::vec3(matrix[0])),
+                glm::dot(glm::vec3(matrix[1]), glm::vec3(matrix[1]))),
+                glm::dot(glm::vec3(matrix[2]), glm::vec3(matrix[2]))));
+
+            return Sphere{ glm::vec3(matrix * glm::vec4(center, 1.0f)), radius * scale };
+        }
+    };
+}
@@ -0,0 +1,129 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#include "Frame_Uniforms.hpp"
+#include "Camera.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace udit
+{
+    static_assert(sizeof(Frame_Uniforms::Frame ) == 256, "Frame no coincide con el bloque std140");
+    static_assert(sizeof(Frame_Uniforms::Object) == 176, "Object no coincide con el bloque std140");
+
+    const GLuint Frame_Uniforms::FRAME_BINDING;
+    const GLuint Frame_Uniforms::OBJECT_BINDING;
+
+    const char* const Frame_Uniforms::FRAME_BLOCK = R"(
+        layout (std140) uniform Frame
+        {
+            mat4 projection;
+            mat4 view;
+            mat4 view_projection;
+            vec4 camera_position;
+            vec4 light_position;
+            vec4 light_color;
+            vec4 fog;
+        };
+    )";
+
+    const char* const Frame_Uniforms::OBJECT_BLOCK = R"(
+        layout (std140) uniform Object
+        {
+            mat4 model;
+            mat4 normal_matrix;
+            vec4 parameters;
+            vec4 position_scale;
+            vec4 position_offset;
+        };
+    )";
+
+    Frame_Uniforms::Frame_Uniforms() : frame_buffer(0), object_buffer(0), object_capacity(0)
+    {
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+        object_stride = (sizeof(Object) + size_t(alignment) - 1) / size_t(alignment) * size_t(alignment);
+
+        glGenBuffers(1, &frame_buffer);
+        glGenBuffers(1, &object_buffer);
+
+        glBindBuffer(GL_UNIFORM_BUFFER, frame_buffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(Frame), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_BINDING, frame_buffer);
+    }
+
+    Frame_Uniforms::~Frame_Uniforms()
+    {
+        glDeleteBuffers(1, &frame_buffer);
+        glDeleteBuffers(1, &object_buffer);
+    }
+
+    void Frame_Uniforms::bind_blocks(GLuint program_id)
+    {
+        // Sin layout(binding) en GLSL 3.30 la asociación se hace desde la aplicación
+        GLuint frame_index  = glGetUniformBlockIndex(program_id, "Frame");
+        GLuint object_index = glGetUniformBlockIndex(program_id, "Object");
+
+        if (frame_index  != GL_INVALID_INDEX) glUniformBlockBinding(program_id, frame_index,  FRAME_BINDING);
+        if (object_index != GL_INVALID_INDEX) glUniformBlockBinding(program_id, object_index, OBJECT_BINDING);
+    }
+
+    void Frame_Uniforms::bind_object(const Object_Slot& slot)
+    {
+        glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BINDING, slot.buffer, slot.offset, sizeof(Object));
+    }
+
+    void Frame_Uniforms::set_frame(const Camera& camera, const glm::vec3& light_position, const glm::vec3& light_color, const glm::vec4& fog)
+    {
+        UDIT_TRACE_SCOPE("Frame_Uniforms::set_frame");
+
+        Frame frame;
+
+        frame.projection      = camera.get_projection_matrix();
+        frame.view            = camera.get_transform_matrix_inverse();
+        frame.view_projection = frame.projection * frame.view;
+        frame.camera_position = glm::vec4(glm::vec3(camera.get_location()), 1.0f);
+        frame.light_position  = glm::vec4(light_position, 1.0f);
+        frame.light_color     = glm::vec4(light_color,    1.0f);
+        frame.fog             = fog;
+
+        glBindBuffer   (GL_UNIFORM_BUFFER, frame_buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Frame), &frame);
+        glBindBuffer   (GL_UNIFORM_BUFFER, 0);
+
+        glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_BINDING, frame_buffer);
+    }
+
+    Frame_Uniforms::Object_Slot Frame_Uniforms::add_object(const Object& object)
+    {
+        Object_Slot slot;
+
+        slot.buffer = object_buffer;
+        slot.offset = GLintptr(objects.size());
+
+        objects.resize(objects.size() + object_stride);
+        std::memcpy(objects.data() + slot.offset, &object, sizeof(Object));
+
+        return slot;
+    }
+
+    void Frame_Uniforms::end_objects()
+    {
+        UDIT_TRACE_SCOPE("Frame_Uniforms::end_objects");
+
+        if (objects.empty()) return;
+
+        glBindBuffer(GL_UNIFORM_BUFFER, object_buffer);
+
+        // Almacenamiento nuevo en cada frame (orphaning) para no esperar a los dibujos anteriores
+        object_capacity = std::max(object_capacity, objects.size());
+
+        glBufferData   (GL_UNIFORM_BUFFER, object_capacity, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, objects.size(), objects.data());
+        glBindBuffer   (GL_UNIFORM_BUFFER, 0);
+    }
+}
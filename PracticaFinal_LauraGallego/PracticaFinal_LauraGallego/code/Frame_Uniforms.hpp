@@ -0,0 +1,92 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glad/gl.h>
+#include <glm.hpp>
+
+namespace udit
+{
+    class Camera;
+
+    // Bloques de uniforms std140 compartidos por todos los programas de la escena:
+    //
+    //   Frame  (punto 0): cámara, luz y niebla; se sube una vez por frame.
+    //   Object (punto 1): datos de cada dibujo, calculados en la CPU. Los de todo el
+    //                     frame se suben juntos y cada dibujo enlaza su rango.
+    class Frame_Uniforms
+    {
+    public:
+
+        static const GLuint FRAME_BINDING  = 0;
+        static const GLuint OBJECT_BINDING = 1;
+
+        // Declaraciones GLSL de los bloques para insertar tras la línea #version
+        static const char* const FRAME_BLOCK;
+        static const char* const OBJECT_BLOCK;
+
+        // Espejo en C++ de los bloques (std140: mat4 y vec4 sin relleno adicional)
+        struct Frame
+        {
+            glm::mat4 projection;
+            glm::mat4 view;
+            glm::mat4 view_projection;
+            glm::vec4 camera_position;      // xyz
+            glm::vec4 light_position;       // xyz
+            glm::vec4 light_color;          // rgb
+            glm::vec4 fog;                  // rgb = color, a = densidad
+        };
+
+        struct Object
+        {
+            glm::mat4 model;
+            glm::mat4 normal_matrix;        // Inversa traspuesta de la parte 3x3 de model
+            glm::vec4 parameters;           // x = opacidad, y = 1 si se dibuja en el pase OIT
+            glm::vec4 position_scale;       // Reconstrucción de posiciones cuantizadas
+            glm::vec4 position_offset;
+        };
+
+        // Rango de un dibujo dentro del buffer de objetos del frame actual
+        struct Object_Slot
+        {
+            GLuint   buffer = 0;
+            GLintptr offset = 0;
+        };
+
+    private:
+
+        GLuint frame_buffer;
+        GLuint object_buffer;
+
+        size_t object_stride;               // sizeof(Object) alineado a GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+        size_t object_capacity;             // Bytes reservados en object_buffer
+
+        std::vector<uint8_t> objects;       // Datos de los dibujos del frame en curso
+
+    public:
+
+        Frame_Uniforms();
+       ~Frame_Uniforms();
+
+        Frame_Uniforms(const Frame_Uniforms&) = delete;
+        Frame_Uniforms& operator=(const Frame_Uniforms&) = delete;
+
+        // Asocia los bloques que declare el programa a sus puntos de enlace
+        static void bind_blocks(GLuint program_id);
+
+        // Enlaza el rango de un dibujo en el punto de Object
+        static void bind_object(const Object_Slot& slot);
+
+        // Sube el bloque Frame y lo deja enlazado
+        void set_frame(const Camera& camera, const glm::vec3& light_position, const glm::vec3& light_color, const glm::vec4& fog);
+
+        // Acumula los datos de cada dibujo del frame y los sube todos con end_objects()
+        void        begin_objects() { objects.clear(); }
+        Object_Slot add_object   (const Object& object);
+        void        end_objects  ();
+    };
+}
@@ -0,0 +1,126 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#include "Frustum.hpp"
+#include "Camera.hpp"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+    #define UDIT_X86 1
+    #include <emmintrin.h>
+#endif
+
+namespace udit
+{
+    Frustum::Frustum(const Camera& camera)
+    {
+        set(camera.get_projection_matrix() * camera.get_transform_matrix_inverse());
+    }
+
+    void Frustum::set(const glm::mat4& m)
+    {
+        // Gribb-Hartmann: cada plano es la fila 3 más o menos otra fila de la matriz
+        glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+        planes[0] = row3 + row0;
+        planes[1] = row3 - row0;
+        planes[2] = row3 + row1;
+        planes[3] = row3 - row1;
+        planes[4] = row3 + row2;
+        planes[5] = row3 - row2;
+
+        // Normalizados para que la distancia con signo se pueda comparar con radios
+        for (glm::vec4& plane : planes)
+        {
+            plane /= glm::length(glm::vec3(plane));
+        }
+    }
+
+    bool Frustum::intersects(const Sphere& sphere) const
+    {
+        for (const glm::vec4& plane : planes)
+        {
+            if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius) return false;
+        }
+
+        return true;
+    }
+
+    bool Frustum::intersects(const Aabb& box) const
+    {
+        if (box.is_empty()) return false;
+
+        glm::vec3 center = box.get_center();
+        glm::vec3 extent = box.get_extent();
+
+        // Radio de la caja proyectado sobre la normal de cada plano
+        for (const glm::vec4& plane : planes)
+        {
+            float radius   = glm::dot(glm::abs(glm::vec3(plane)), extent);
+            float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+
+            if (distance < -radius) return false;
+        }
+
+        return true;
+    }
+
+    size_t Frustum::test_spheres(const float* x, const float* y, const float* z, const float* radius, uint8_t* visible, size_t count) const
+    {
+        size_t visible_count = 0;
+        size_t i = 0;
+
+        #ifdef UDIT_X86
+
+        __m128 plane_x[6], plane_y[6], plane_z[6], plane_w[6];
+
+        for (int p = 0; p < 6; ++p)
+        {
+            plane_x[p] = _mm_set1_ps(planes[p].x);
+            plane_y[p] = _mm_set1_ps(planes[p].y);
+            plane_z[p] = _mm_set1_ps(planes[p].z);
+            plane_w[p] = _mm_set1_ps(planes[p].w);
+        }
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 sx = _mm_loadu_ps(x + i);
+            __m128 sy = _mm_loadu_ps(y + i);
+            __m128 sz = _mm_loadu_ps(z + i);
+            __m128 nr = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+
+            // Una esfera está fuera si su distancia a algún plano es menor que -radio
+            __m128 outside = _mm_setzero_ps();
+
+            for (int p = 0; p < 6; ++p)
+            {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane_x[p], sx), _mm_mul_ps(plane_y[p], sy)),
+                                             _mm_add_ps(_mm_mul_ps(plane_z[p], sz), plane_w[p]));
+
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, nr));
+            }
+
+            int mask = _mm_movemask_ps(outside);
+
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                uint8_t inside = uint8_t(((mask >> lane) & 1) ^ 1);
+                visible[i + lane] = inside;
+                visible_count    += inside;
+            }
+        }
+
+        #endif
+
+        for (; i < count; ++i)
+        {
+            uint8_t inside = intersects(Sphere{ glm::vec3(x[i], y[i], z[i]), radius[i] }) ? 1 : 0;
+            visible[i]     = inside;
+            visible_count += inside;
+        }
+
+        return visible_count;
+    }
+}
@@ -0,0 +1,40 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+#include "Bounds.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <glm.hpp>
+
+namespace udit
+{
+    class Camera;
+
+    // Pirámide de visión como seis planos (normal hacia dentro) extraídos de proyección x vista
+    class Frustum
+    {
+    private:
+
+        glm::vec4 planes[6];            // left, right, bottom, top, near, far
+
+    public:
+
+        Frustum() = default;
+        explicit Frustum(const glm::mat4& view_projection) { set(view_projection); }
+        explicit Frustum(const Camera& camera);
+
+        void set(const glm::mat4& view_projection);
+
+        const glm::vec4& get_plane(int index) const { return planes[index]; }
+
+        bool intersects(const Sphere& sphere) const;
+        bool intersects(const Aabb& box) const;
+
+        // Prueba por lotes de esferas en formato SoA; escribe 1 en visible[i] si la
+        // esfera i toca la pirámide. Con SSE se prueban cuatro esferas a la vez.
+        // Devuelve el número de esferas visibles.
+        size_t test_spheres(const float* x, const float* y, const float* z, const float* radius, uint8_t* visible, size_t count) const;
+    };
+}
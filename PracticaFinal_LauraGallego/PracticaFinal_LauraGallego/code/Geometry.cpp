@@ -0,0 +1,364 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#include "Geometry.hpp"
+#include "Mesh_Cache.hpp"
+#include "Mesh_Optimizer.hpp"
+#include "Mesh_Simplifier.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <half.hpp>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+namespace udit
+{
+    namespace
+    {
+        static_assert(sizeof(Geometry::Compact_Vertex) == 16, "Compact_Vertex debe ocupar 16 bytes");
+
+        // Normalizado con signo de 10 bits en las posiciones 0, 10 y 20
+        uint32_t pack_normal(const glm::vec3& normal)
+        {
+            glm::vec3 n = glm::clamp(normal, -1.0f, 1.0f) * 511.0f;
+
+            uint32_t x = uint32_t(int32_t(std::lround(n.x))) & 0x3FF;
+            uint32_t y = uint32_t(int32_t(std::lround(n.y))) & 0x3FF;
+            uint32_t z = uint32_t(int32_t(std::lround(n.z))) & 0x3FF;
+
+            return x | (y << 10) | (z << 20);
+        }
+
+        uint16_t to_half(float value)
+        {
+            half_float::half h(value);
+            uint16_t bits;
+            std::memcpy(&bits, &h, sizeof(bits));
+            return bits;
+        }
+    }
+
+    Geometry::Geometry()
+        : index_count(0), vertex_count(0),
+          format(Vertex_Format::FULL), index_type(GL_UNSIGNED_INT), vertex_bytes(0), index_bytes(0),
+          position_scale(1.0f), position_offset(0.0f)
+    {
+    }
+
+    Geometry::~Geometry()
+    {
+        if (buffer) buffer->release(allocation);
+    }
+
+    std::shared_ptr<Geometry> Geometry::load(const std::string& path, Vertex_Format format)
+    {
+        Data data;
+
+        return import(path, format, data) ? create(data) : nullptr;
+    }
+
+    bool Geometry::import(const std::string& path, Vertex_Format format, Data& data)
+    {
+        UDIT_TRACE_SCOPE("Geometry::import");
+
+        if (import_cached(path, data))
+        {
+            if (format == Vertex_Format::COMPACT) compact(data);
+            return true;
+        }
+
+        // Uso de Assimp para carga y normalización del modelo
+        Assimp::Importer importer;
+
+        const aiScene* scene;
+        {
+            UDIT_TRACE_SCOPE("Assimp::Importer::ReadFile");
+            scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals);
+        }
+
+        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+        {
+            std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
+            return false;
+        }
+
+        process_node(scene->mRootNode, scene, data);
+
+        // Soldado y reordenación; el resultado se guarda en la caché y no se repite
+        mesh_optimizer::optimize(data.vertices, data.indices, data.submeshes);
+
+        // Niveles de detalle a continuación de los índices completos
+        mesh_simplifier::build_lods(data.vertices, data.indices, data.lods);
+
+        // Esfera centrada en la caja con el radio ajustado a los vértices reales
+        data.sphere.center = data.bounds.get_center();
+        for (const Vertex& vertex : data.vertices) {
+            data.sphere.radius = glm::max(data.sphere.radius, glm::length(vertex.Position - data.sphere.center));
+        }
+
+        std::cout << "EXITO: Modelo importado: " << path << " (" << data.vertices.size() << " vertices)" << std::endl;
+        if (data.vertices.size() == 0) std::cout << "ALERTA: El modelo esta vacio!" << std::endl;
+
+        if (!mesh_cache::write(path, data.vertices, data.indices, data.submeshes, data.lods, data.bounds, data.sphere))
+        {
+            std::cout << "ALERTA: No se pudo escribir la cache " << mesh_cache::get_cache_path(path) << std::endl;
+        }
+
+        if (format == Vertex_Format::COMPACT) compact(data);
+
+        return true;
+    }
+
+    void Geometry::compact(Data& data)
+    {
+        UDIT_TRACE_SCOPE("Geometry::compact");
+
+        const Vertex*   vertices     = data.cache ? data.cache->vertices : data.vertices.data();
+        const uint32_t* indices      = data.cache ? data.cache->indices  : data.indices .data();
+        size_t          vertex_count = data.cache ? data.cache->header->vertex_count : data.vertices.size();
+        size_t          index_count  = data.cache ? data.cache->header->index_count  : data.indices .size();
+
+        // Las posiciones se cuantizan en [0, 1] dentro de la caja (ejes planos: escala 1)
+        glm::vec3 extent = data.bounds.is_empty() ? glm::vec3(1.0f) : data.bounds.max - data.bounds.min;
+        for (int axis = 0; axis < 3; ++axis) if (extent[axis] <= 0.0f) extent[axis] = 1.0f;
+
+        data.position_offset = data.bounds.is_empty() ? glm::vec3(0.0f) : data.bounds.min;
+        data.position_scale  = extent;
+
+        data.compact_vertices.resize(vertex_count);
+
+        for (size_t i = 0; i < vertex_count; ++i)
+        {
+            const Vertex&   source = vertices[i];
+            Compact_Vertex& target = data.compact_vertices[i];
+
+            glm::vec3 unit = glm::clamp((source.Position - data.position_offset) / extent, 0.0f, 1.0f);
+
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                target.Position[axis] = uint16_t(unit[axis] * 65535.0f + 0.5f);
+            }
+
+            target.Padding      = 0;
+            target.Normal       = pack_normal(source.Normal);
+            target.TexCoords[0] = to_half(source.TexCoords.x);
+            target.TexCoords[1] = to_half(source.TexCoords.y);
+        }
+
+        // Índices de 16 bits cuando todos los vértices son direccionables
+        if (vertex_count < 65536)
+        {
+            data.short_indices.assign(indices, indices + index_count);
+        }
+
+        data.format = Vertex_Format::COMPACT;
+    }
+
+    bool Geometry::import_cached(const std::string& path, Data& data)
+    {
+        UDIT_TRACE_SCOPE("Geometry::import_cached");
+
+        std::shared_ptr<mesh_cache::View> view = std::make_shared<mesh_cache::View>();
+
+        if (!mesh_cache::open(path, *view)) return false;
+
+        const mesh_cache::Header& header = *view->header;
+
+        data.bounds.min    = glm::vec3(header.bounds_min[0], header.bounds_min[1], header.bounds_min[2]);
+        data.bounds.max    = glm::vec3(header.bounds_max[0], header.bounds_max[1], header.bounds_max[2]);
+        data.sphere.center = glm::vec3(header.sphere[0], header.sphere[1], header.sphere[2]);
+        data.sphere.radius = header.sphere[3];
+
+        data.submeshes.assign(view->submeshes, view->submeshes + header.submesh_count);
+        data.lods     .assign(view->lods,      view->lods      + header.lod_count);
+        data.cache = view;
+
+        std::cout << "INFO: Modelo cargado desde cache: " << path << " (" << header.vertex_count << " vertices)" << std::endl;
+
+        return true;
+    }
+
+    std::shared_ptr<Geometry> Geometry::create(const Data& data)
+    {
+        UDIT_TRACE_SCOPE("Geometry::create");
+
+        std::shared_ptr<Geometry> geometry = std::make_shared<Geometry>();
+
+        geometry->local_bounds = data.bounds;
+        geometry->local_sphere = data.sphere;
+        geometry->submeshes    = data.submeshes;
+        geometry->lods         = data.lods;
+
+        geometry->format          = data.format;
+        geometry->position_scale  = data.position_scale;
+        geometry->position_offset = data.position_offset;
+
+        const void* indices     = data.cache ? (const void*)data.cache->indices : (const void*)data.indices.data();
+        size_t      index_count = data.cache ? data.cache->header->index_count  : data.indices.size();
+
+        if (data.format == Vertex_Format::COMPACT)
+        {
+            if (!data.short_indices.empty())
+            {
+                geometry->index_type = GL_UNSIGNED_SHORT;
+                indices = data.short_indices.data();
+            }
+
+            geometry->upload(data.compact_vertices.data(), data.compact_vertices.size(), indices, index_count);
+        }
+        else if (data.cache)
+        {
+            // Desde la caché se sube directamente de la proyección del archivo, sin copias
+            geometry->upload(data.cache->vertices, data.cache->header->vertex_count, indices, index_count);
+        }
+        else
+        {
+            geometry->upload(data.vertices.data(), data.vertices.size(), indices, index_count);
+        }
+
+        if (geometry->lods.empty())
+        {
+            geometry->lods.push_back({ 0, uint32_t(index_count), 0.0f });
+        }
+
+        return geometry;
+    }
+
+    void Geometry::process_node(aiNode* node, const aiScene* scene, Data& data)
+    {
+        for (unsigned int i = 0; i < node->mNumMeshes; i++)
+        {
+            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+            process_mesh(mesh, data);
+        }
+
+        for (unsigned int i = 0; i < node->mNumChildren; i++)
+        {
+            process_node(node->mChildren[i], scene, data);
+        }
+    }
+
+    void Geometry::process_mesh(aiMesh* mesh, Data& data)
+    {
+        // Los índices de cada submalla son relativos a sus propios vértices
+        unsigned int base_vertex = static_cast<unsigned int>(data.vertices.size());
+
+        Submesh submesh;
+        submesh.first_index  = static_cast<uint32_t>(data.indices.size());
+        submesh.base_vertex  = base_vertex;
+        submesh.vertex_count = mesh->mNumVertices;
+
+        // Recorrido de todos los vértices del modelo importado
+        for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+        {
+            Vertex vertex;
+
+            // Copia de posiciones
+            vertex.Position.x = mesh->mVertices[i].x;
+            vertex.Position.y = mesh->mVertices[i].y;
+            vertex.Position.z = mesh->mVertices[i].z;
+
+            data.bounds.extend(vertex.Position);
+
+            // Copia de normales si existen
+            if (mesh->HasNormals())
+            {
+                vertex.Normal.x = mesh->mNormals[i].x;
+                vertex.Normal.y = mesh->mNormals[i].y;
+                vertex.Normal.z = mesh->mNormals[i].z;
+            }
+            else vertex.Normal = glm::vec3(0.0f, 1.0f, 0.0f);
+
+            // Copia de coordenadas de textura
+            if (mesh->mTextureCoords[0])
+            {
+                vertex.TexCoords.x = mesh->mTextureCoords[0][i].x;
+                vertex.TexCoords.y = mesh->mTextureCoords[0][i].y;
+            }
+            else
+            {
+                vertex.TexCoords = glm::vec2(0.0f, 0.0f);
+            }
+
+            data.vertices.push_back(vertex);
+        }
+
+        // Copia de índices para formación de triángulos
+        for (unsigned int i = 0; i < mesh->mNumFaces; i++)
+        {
+            const aiFace& face = mesh->mFaces[i];
+            for (unsigned int j = 0; j < face.mNumIndices; j++)
+                data.indices.push_back(base_vertex + face.mIndices[j]);
+        }
+
+        submesh.index_count = static_cast<uint32_t>(data.indices.size()) - submesh.first_index;
+        data.submeshes.push_back(submesh);
+    }
+
+    void Geometry::upload(const void* vertices, size_t vertex_count, const void* indices, size_t index_count)
+    {
+        bool compact = format == Vertex_Format::COMPACT;
+
+        this->vertex_count = vertex_count;
+        this->index_count  = static_cast<GLsizei>(index_count);
+
+        vertex_bytes = vertex_count * (compact ? sizeof(Compact_Vertex) : sizeof(Vertex));
+        index_bytes  = index_count  * (index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t));
+
+        buffer     = Geometry_Buffer::acquire(format, index_type);
+        allocation = buffer->allocate(vertices, vertex_count, indices, index_count);
+
+        std::cout << "INFO: Geometria subida (" << (compact ? "compacta" : "completa") << "): "
+                  << vertex_bytes / 1024 << " KB de vertices, " << index_bytes / 1024 << " KB de indices" << std::endl;
+    }
+
+    size_t Geometry::select_lod(size_t current_lod, float pixels_per_unit, float max_error_pixels) const
+    {
+        // Margen de histéresis: un nivel más simple solo se elige si su error cabe en esta
+        // fracción del máximo, y solo se vuelve al más detallado si se supera el máximo
+        const float HYSTERESIS = 0.75f;
+
+        size_t lod = std::min(current_lod, lods.size() - 1);
+
+        while (lod > 0 && lods[lod].error * pixels_per_unit > max_error_pixels) lod--;
+
+        while (lod + 1 < lods.size() && lods[lod + 1].error * pixels_per_unit < max_error_pixels * HYSTERESIS) lod++;
+
+        return lod;
+    }
+
+    void Geometry::draw(size_t lod) const
+    {
+        glBindVertexArray(buffer->get_vao());
+        draw_bound(lod);
+        glBindVertexArray(0);
+    }
+
+    void Geometry::draw_bound(size_t lod) const
+    {
+        const Lod&  range   = lods[lod];
+
+        if (range.index_count == 0) return;
+
+        const void* offset  = (const void*)((allocation.first_index + range.first_index) * buffer->get_index_size());
+
+        glDrawElementsBaseVertex(GL_TRIANGLES, GLsizei(range.index_count), index_type, offset, GLint(allocation.base_vertex));
+    }
+
+    void Geometry::draw_instanced(GLsizei instance_count, size_t lod) const
+    {
+        const Lod&  range   = lods[lod];
+
+        if (range.index_count == 0) return;
+
+        const void* offset  = (const void*)((allocation.first_index + range.first_index) * buffer->get_index_size());
+
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, GLsizei(range.index_count), index_type, offset, instance_count, GLint(allocation.base_vertex));
+    }
+}
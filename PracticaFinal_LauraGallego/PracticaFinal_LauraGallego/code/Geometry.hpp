@@ -0,0 +1,179 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+#include "Bounds.hpp"
+#include "Geometry_Buffer.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glad/gl.h>
+#include <glm.hpp>
+
+struct aiNode;
+struct aiMesh;
+struct aiScene;
+
+namespace udit
+{
+    namespace mesh_cache { struct View; }
+
+    enum class Vertex_Format
+    {
+        FULL,           // Geometry::Vertex: 32 bytes en float e índices de 32 bits
+        COMPACT         // Geometry::Compact_Vertex: 16 bytes e índices de 16 bits si caben
+    };
+
+    // Geometría importada y subida a la GPU. Se comparte entre todas las mallas
+    // que usan el mismo archivo (ver Resource_Cache). Sus vértices e índices son un
+    // rango del Geometry_Buffer de su formato.
+    class Geometry
+    {
+    public:
+
+        struct Vertex
+        {
+            glm::vec3 Position;
+            glm::vec3 Normal;
+            glm::vec2 TexCoords;
+        };
+
+        // Posición en unorm16 relativa a la caja de la geometría, normal en
+        // GL_INT_2_10_10_10_REV y UV en half float
+        struct Compact_Vertex
+        {
+            uint16_t Position[3];
+            uint16_t Padding;
+            uint32_t Normal;
+            uint16_t TexCoords[2];
+        };
+
+        // Rango de cada aiMesh del archivo dentro de los buffers compartidos
+        struct Submesh
+        {
+            uint32_t first_index;
+            uint32_t index_count;
+            uint32_t base_vertex;
+            uint32_t vertex_count;
+        };
+
+        // Nivel de detalle: rango de índices sobre los mismos vértices y error geométrico
+        // (en unidades del modelo) respecto a la malla completa
+        struct Lod
+        {
+            uint32_t first_index;
+            uint32_t index_count;
+            float    error;
+        };
+
+        // Resultado de la fase de CPU de la carga, listo para subir
+        struct Data
+        {
+            std::vector<Vertex>   vertices;
+            std::vector<uint32_t> indices;
+            std::vector<Submesh>  submeshes;
+            std::vector<Lod>      lods;
+            Aabb                  bounds;
+            Sphere                sphere;
+
+            // Si viene de la caché binaria, vértices e índices se leen de la proyección
+            std::shared_ptr<mesh_cache::View> cache;
+
+            // Solo en formato compacto
+            Vertex_Format               format = Vertex_Format::FULL;
+            std::vector<Compact_Vertex> compact_vertices;
+            std::vector<uint16_t>       short_indices;
+            glm::vec3                   position_scale  = glm::vec3(1.0f);
+            glm::vec3                   position_offset = glm::vec3(0.0f);
+        };
+
+    private:
+
+        // Rangos propios dentro del buffer compartido de su formato
+        std::shared_ptr<Geometry_Buffer> buffer;
+        Geometry_Buffer::Allocation      allocation;
+
+        GLsizei index_count;
+        size_t  vertex_count;
+
+        Vertex_Format format;
+        GLenum        index_type;
+        size_t        vertex_bytes;
+        size_t        index_bytes;
+
+        // Reconstrucción de la posición en el vertex shader: aPos * scale + offset
+        glm::vec3     position_scale;
+        glm::vec3     position_offset;
+
+        Aabb    local_bounds;
+        Sphere  local_sphere;
+
+        std::vector<Submesh> submeshes;
+        std::vector<Lod>     lods;
+
+    public:
+
+        // Fase de CPU (cualquier hilo): proyecta la caché binaria (Mesh_Cache) o, si no es
+        // válida, importa el archivo con Assimp y escribe la caché. Con formato compacto se
+        // cuantizan además los vértices. False si no se puede cargar.
+        static bool import(const std::string& path, Vertex_Format format, Data& data);
+
+        // Fase de GPU (hilo de OpenGL): sube los buffers
+        static std::shared_ptr<Geometry> create(const Data& data);
+
+        // Ambas fases seguidas
+        static std::shared_ptr<Geometry> load(const std::string& path, Vertex_Format format);
+
+        Geometry();
+       ~Geometry();
+
+        Geometry(const Geometry&) = delete;
+        Geometry& operator=(const Geometry&) = delete;
+
+        GLuint  get_vao         () const { return buffer->get_vao(); }
+        GLsizei get_index_count () const { return index_count; }
+        size_t  get_vertex_count() const { return vertex_count; }
+        GLenum  get_index_type  () const { return index_type; }
+
+        Vertex_Format get_format      () const { return format; }
+        size_t        get_vertex_bytes() const { return vertex_bytes; }
+        size_t        get_index_bytes () const { return index_bytes; }
+
+        const glm::vec3& get_position_scale () const { return position_scale; }
+        const glm::vec3& get_position_offset() const { return position_offset; }
+
+        const Aabb&   get_local_bounds() const { return local_bounds; }
+        const Sphere& get_local_sphere() const { return local_sphere; }
+
+        const std::vector<Submesh>& get_submeshes() const { return submeshes; }
+        const std::vector<Lod>&     get_lods     () const { return lods;      }
+
+        const Geometry_Buffer&             get_buffer    () const { return *buffer;    }
+        const Geometry_Buffer::Allocation& get_allocation() const { return allocation; }
+
+        // Nivel de detalle para la malla: el más simple cuyo error proyectado no supere
+        // max_error_pixels. pixels_per_unit es la escala de proyección a la distancia de
+        // la malla (ya multiplicada por la escala del modelo). Para evitar parpadeos solo
+        // se pasa a un nivel más simple cuando su error queda holgadamente por debajo.
+        size_t select_lod(size_t current_lod, float pixels_per_unit, float max_error_pixels) const;
+
+        void draw(size_t lod = 0) const;
+
+        // Con el VAO del buffer ya enlazado (Render_Queue lo enlaza solo cuando cambia)
+        void draw_bound(size_t lod = 0) const;
+
+        // Con el VAO del buffer ya enlazado y preparado para leer los atributos por instancia
+        void draw_instanced(GLsizei instance_count, size_t lod = 0) const;
+
+    private:
+
+        static bool import_cached(const std::string& path, Data& data);
+        static void process_node (aiNode* node, const aiScene* scene, Data& data);
+        static void process_mesh (aiMesh* mesh, Data& data);
+        static void compact      (Data& data);
+
+        void upload(const void* vertices, size_t vertex_count, const void* indices, size_t index_count);
+    };
+}
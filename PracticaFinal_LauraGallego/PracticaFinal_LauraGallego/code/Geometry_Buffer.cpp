@@ -0,0 +1,206 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#include "Geometry_Buffer.hpp"
+#include "Geometry.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+
+namespace udit
+{
+    namespace
+    {
+        // Tamaño inicial de cada buffer; después se duplica cuando hace falta
+        const size_t INITIAL_VERTEX_CAPACITY = 64 * 1024;
+        const size_t INITIAL_INDEX_CAPACITY  = 256 * 1024;
+
+        // Una entrada por formato de vértice y tipo de índice (16 o 32 bits)
+        std::weak_ptr<Geometry_Buffer> buffers[2][2];
+
+        int index_slot(GLenum index_type) { return index_type == GL_UNSIGNED_SHORT ? 0 : 1; }
+    }
+
+    std::shared_ptr<Geometry_Buffer> Geometry_Buffer::acquire(Vertex_Format format, GLenum index_type)
+    {
+        std::weak_ptr<Geometry_Buffer>& slot = buffers[int(format)][index_slot(index_type)];
+
+        std::shared_ptr<Geometry_Buffer> buffer = slot.lock();
+
+        if (!buffer)
+        {
+            buffer = std::make_shared<Geometry_Buffer>(format, index_type);
+            slot   = buffer;
+        }
+
+        return buffer;
+    }
+
+    std::vector<Geometry_Buffer::Statistics> Geometry_Buffer::get_all_statistics()
+    {
+        std::vector<Statistics> statistics;
+
+        for (auto& by_format : buffers)
+        {
+            for (auto& slot : by_format)
+            {
+                if (std::shared_ptr<Geometry_Buffer> buffer = slot.lock()) statistics.push_back(buffer->get_statistics());
+            }
+        }
+
+        return statistics;
+    }
+
+    Geometry_Buffer::Geometry_Buffer(Vertex_Format format, GLenum index_type)
+    :
+        format       (format),
+        index_type   (index_type),
+        vertex_size  (format == Vertex_Format::COMPACT ? sizeof(Geometry::Compact_Vertex) : sizeof(Geometry::Vertex)),
+        index_size   (index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t)),
+        vao(0), vbo(0), ebo(0),
+        resizes      (0)
+    {
+        glGenVertexArrays(1, &vao);
+    }
+
+    Geometry_Buffer::~Geometry_Buffer()
+    {
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(1, &vbo);
+        glDeleteBuffers(1, &ebo);
+    }
+
+    Geometry_Buffer::Allocation Geometry_Buffer::allocate(const void* vertices, size_t vertex_count, const void* indices, size_t index_count)
+    {
+        UDIT_TRACE_SCOPE("Geometry_Buffer::allocate");
+
+        Allocation allocation;
+
+        // Una geometría vacía no ocupa rango: Range_Allocator::allocate(0) devuelve INVALID
+        // y eso no debe confundirse con falta de sitio
+        if (vertex_count == 0 || index_count == 0) return allocation;
+
+        allocation.vertex_count = vertex_count;
+        allocation.index_count  = index_count;
+        allocation.base_vertex  = vertex_ranges.allocate(vertex_count);
+        allocation.first_index  = index_ranges .allocate(index_count);
+
+        if (allocation.base_vertex == Range_Allocator::INVALID || allocation.first_index == Range_Allocator::INVALID)
+        {
+            // Sin hueco: se amplía el buffer que no tenía sitio y se reintenta
+            if (allocation.base_vertex != Range_Allocator::INVALID) vertex_ranges.free(allocation.base_vertex, vertex_count);
+            if (allocation.first_index != Range_Allocator::INVALID) index_ranges .free(allocation.first_index, index_count);
+
+            size_t vertex_capacity = vertex_ranges.get_capacity();
+            size_t index_capacity  = index_ranges .get_capacity();
+
+            if (allocation.base_vertex == Range_Allocator::INVALID) vertex_capacity = std::max(std::max(vertex_capacity * 2, INITIAL_VERTEX_CAPACITY), vertex_capacity + vertex_count);
+            if (allocation.first_index == Range_Allocator::INVALID) index_capacity  = std::max(std::max(index_capacity  * 2, INITIAL_INDEX_CAPACITY ), index_capacity  + index_count );
+
+            reserve(vertex_capacity, index_capacity);
+
+            allocation.base_vertex = vertex_ranges.allocate(vertex_count);
+            allocation.first_index = index_ranges .allocate(index_count);
+        }
+
+        // El VAO se enlaza antes que el EBO para no tocar el de otro VAO
+        glBindVertexArray(vao);
+
+        glBindBuffer   (GL_ARRAY_BUFFER, vbo);
+        glBufferSubData(GL_ARRAY_BUFFER,         allocation.base_vertex * vertex_size, vertex_count * vertex_size, vertices);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, allocation.first_index * index_size,  index_count  * index_size,  indices);
+
+        glBindVertexArray(0);
+
+        return allocation;
+    }
+
+    void Geometry_Buffer::release(const Allocation& allocation)
+    {
+        vertex_ranges.free(allocation.base_vertex, allocation.vertex_count);
+        index_ranges .free(allocation.first_index, allocation.index_count);
+    }
+
+    Geometry_Buffer::Statistics Geometry_Buffer::get_statistics() const
+    {
+        return Statistics{ format, index_type, vertex_ranges.get_statistics(), index_ranges.get_statistics(), resizes };
+    }
+
+    void Geometry_Buffer::reserve(size_t vertex_capacity, size_t index_capacity)
+    {
+        UDIT_TRACE_SCOPE("Geometry_Buffer::reserve");
+
+        // Buffers nuevos con el contenido de los anteriores copiado en la GPU; los
+        // rangos ya repartidos conservan sus offsets
+        GLuint new_vbo, new_ebo;
+
+        glGenBuffers(1, &new_vbo);
+        glGenBuffers(1, &new_ebo);
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, new_vbo);
+        glBufferData(GL_COPY_WRITE_BUFFER, vertex_capacity * vertex_size, nullptr, GL_STATIC_DRAW);
+
+        if (vbo)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, vbo);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, vertex_ranges.get_capacity() * vertex_size);
+        }
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, new_ebo);
+        glBufferData(GL_COPY_WRITE_BUFFER, index_capacity * index_size, nullptr, GL_STATIC_DRAW);
+
+        if (ebo)
+        {
+            glBindBuffer(GL_COPY_READ_BUFFER, ebo);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, index_ranges.get_capacity() * index_size);
+        }
+
+        glDeleteBuffers(1, &vbo);
+        glDeleteBuffers(1, &ebo);
+
+        vbo = new_vbo;
+        ebo = new_ebo;
+
+        vertex_ranges.grow(vertex_capacity);
+        index_ranges .grow(index_capacity);
+
+        set_vertex_attributes();
+
+        if (resizes++ > 0)
+        {
+            std::cout << "INFO: Buffer de geometria ampliado a " << vertex_capacity << " vertices y " << index_capacity << " indices" << std::endl;
+        }
+    }
+
+    void Geometry_Buffer::set_vertex_attributes()
+    {
+        glBindVertexArray(vao);
+
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+        glEnableVertexAttribArray(2);
+
+        if (format == Vertex_Format::COMPACT)
+        {
+            using Compact_Vertex = Geometry::Compact_Vertex;
+
+            glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT,       GL_TRUE,  sizeof(Compact_Vertex), (void*)offsetof(Compact_Vertex, Position));
+            glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV,   GL_TRUE,  sizeof(Compact_Vertex), (void*)offsetof(Compact_Vertex, Normal));
+            glVertexAttribPointer(2, 2, GL_HALF_FLOAT,           GL_FALSE, sizeof(Compact_Vertex), (void*)offsetof(Compact_Vertex, TexCoords));
+        }
+        else
+        {
+            using Vertex = Geometry::Vertex;
+
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+        }
+
+        glBindVertexArray(0);
+    }
+}
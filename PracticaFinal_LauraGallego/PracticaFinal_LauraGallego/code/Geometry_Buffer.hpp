@@ -0,0 +1,87 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+#include "Range_Allocator.hpp"
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <glad/gl.h>
+
+namespace udit
+{
+    enum class Vertex_Format;
+
+    // Buffer de vértices e índices compartido por todas las geometrías con el mismo
+    // formato de vértice y tipo de índice. Cada geometría ocupa un rango de cada buffer
+    // y se dibuja con glDraw*BaseVertex sobre un único VAO, así que pasar de una geometría
+    // a otra ya no cambia de VAO ni de buffers.
+    //
+    // Hay un buffer por combinación; vive mientras alguna geometría lo use.
+    class Geometry_Buffer
+    {
+    public:
+
+        struct Allocation
+        {
+            size_t base_vertex  = Range_Allocator::INVALID;
+            size_t vertex_count = 0;
+            size_t first_index  = Range_Allocator::INVALID;
+            size_t index_count  = 0;
+        };
+
+        struct Statistics
+        {
+            Vertex_Format               format;
+            GLenum                      index_type;
+            Range_Allocator::Statistics vertices;
+            Range_Allocator::Statistics indices;
+            unsigned                    resizes;
+        };
+
+    private:
+
+        Vertex_Format format;
+        GLenum        index_type;
+        size_t        vertex_size;
+        size_t        index_size;
+
+        GLuint vao, vbo, ebo;
+
+        Range_Allocator vertex_ranges;
+        Range_Allocator index_ranges;
+
+        unsigned resizes;
+
+    public:
+
+        // Buffer para la combinación pedida (se crea si no existe); solo en el hilo de OpenGL
+        static std::shared_ptr<Geometry_Buffer> acquire(Vertex_Format format, GLenum index_type);
+
+        // Estadísticas de todos los buffers vivos
+        static std::vector<Statistics> get_all_statistics();
+
+        Geometry_Buffer(Vertex_Format format, GLenum index_type);
+       ~Geometry_Buffer();
+
+        Geometry_Buffer(const Geometry_Buffer&) = delete;
+        Geometry_Buffer& operator=(const Geometry_Buffer&) = delete;
+
+        // Reserva y copia los datos; amplía los buffers si no caben. Sin vértices o sin
+        // índices no se reserva nada y la asignación queda vacía
+        Allocation allocate(const void* vertices, size_t vertex_count, const void* indices, size_t index_count);
+        void       release (const Allocation& allocation);
+
+        GLuint get_vao       () const { return vao;        }
+        GLenum get_index_type() const { return index_type; }
+        size_t get_index_size() const { return index_size; }
+
+        Statistics get_statistics() const;
+
+    private:
+
+        void reserve(size_t vertex_capacity, size_t index_capacity);
+        void set_vertex_attributes();
+    };
+}
@@ -0,0 +1,209 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#include "Gpu_Profiler.hpp"
+#include <iomanip>
+#include <sstream>
+
+namespace udit
+{
+    Gpu_Profiler::Gpu_Profiler() : current_frame(0), enabled(true), in_frame(false)
+    {
+        // La sección raíz mide el frame completo
+        sections.push_back(Section{ "frame", 0, {}, {}, 0, 0, 0.0, 0.0 });
+    }
+
+    Gpu_Profiler::~Gpu_Profiler()
+    {
+        for (Frame& frame : frames)
+        {
+            if (!frame.queries.empty())
+                glDeleteQueries(GLsizei(frame.queries.size()), frame.queries.data());
+        }
+    }
+
+    void Gpu_Profiler::begin_frame()
+    {
+        if (!enabled) return;
+
+        // Se reutiliza el hueco más antiguo del anillo: sus consultas se emitieron
+        // hace frames_in_flight frames y normalmente ya están resueltas
+        current_frame = (current_frame + 1) % frames_in_flight;
+
+        Frame& frame = frames[current_frame];
+        collect(frame);
+
+        frame.used_queries = 0;
+        frame.records.clear();
+
+        stack.clear();
+        open_records.clear();
+        in_frame = true;
+
+        // Apertura de la sección raíz
+        frame.records.push_back(Record{ 0, acquire_query(frame), 0 });
+        glQueryCounter(frame.records.back().start_query, GL_TIMESTAMP);
+        stack.push_back(0);
+        open_records.push_back(0);
+    }
+
+    void Gpu_Profiler::end_frame()
+    {
+        if (!enabled || !in_frame) return;
+
+        while (!stack.empty()) end();
+
+        in_frame = false;
+    }
+
+    void Gpu_Profiler::begin(const std::string& name)
+    {
+        if (!enabled || !in_frame) return;
+
+        Frame& frame = frames[current_frame];
+
+        unsigned section = find_or_add_section(name);
+
+        frame.records.push_back(Record{ section, acquire_query(frame), 0 });
+        glQueryCounter(frame.records.back().start_query, GL_TIMESTAMP);
+
+        stack.push_back(section);
+        open_records.push_back(frame.records.size() - 1);
+    }
+
+    void Gpu_Profiler::end()
+    {
+        if (!enabled || !in_frame || stack.empty()) return;
+
+        Frame& frame = frames[current_frame];
+        Record& record = frame.records[open_records.back()];
+
+        record.end_query = acquire_query(frame);
+        glQueryCounter(record.end_query, GL_TIMESTAMP);
+
+        stack.pop_back();
+        open_records.pop_back();
+    }
+
+    unsigned Gpu_Profiler::find_or_add_section(const std::string& name)
+    {
+        unsigned parent = stack.back();
+
+        // Búsqueda lineal entre los hijos: cada pase tiene pocos grupos
+        for (unsigned child : sections[parent].children)
+        {
+            if (sections[child].name == name) return child;
+        }
+
+        unsigned index = unsigned(sections.size());
+        sections.push_back(Section{ name, sections[parent].depth + 1, {}, {}, 0, 0, 0.0, 0.0 });
+        sections[parent].children.push_back(index);
+
+        return index;
+    }
+
+    GLuint Gpu_Profiler::acquire_query(Frame& frame)
+    {
+        if (frame.used_queries == frame.queries.size())
+        {
+            // El pool del hueco crece por bloques y se conserva entre frames
+            size_t old_size = frame.queries.size();
+            frame.queries.resize(old_size + 32);
+            glGenQueries(32, frame.queries.data() + old_size);
+        }
+
+        return frame.queries[frame.used_queries++];
+    }
+
+    void Gpu_Profiler::collect(Frame& frame)
+    {
+        if (frame.records.empty()) return;
+
+        // El cierre de la sección raíz es la última consulta emitida: si está lista,
+        // todas lo están. Si no, se descarta el frame en lugar de esperar a la GPU.
+        GLuint last_query = frame.records.front().end_query;
+        if (last_query == 0) return;
+
+        GLint available = 0;
+        glGetQueryObjectiv(last_query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return;
+
+        for (Section& section : sections) section.frame_time = 0.0;
+
+        for (const Record& record : frame.records)
+        {
+            if (record.end_query == 0) continue;
+
+            GLuint64 start_ns = 0, end_ns = 0;
+            glGetQueryObjectui64v(record.start_query, GL_QUERY_RESULT, &start_ns);
+            glGetQueryObjectui64v(record.end_query,   GL_QUERY_RESULT, &end_ns);
+
+            sections[record.section].frame_time += double(end_ns - start_ns) / 1000000.0;
+        }
+
+        for (Section& section : sections) add_sample(section, section.frame_time);
+    }
+
+    void Gpu_Profiler::add_sample(Section& section, double milliseconds)
+    {
+        // Ventana deslizante con suma acumulada
+        if (section.sample_count == window_size) section.sample_sum -= section.samples[section.next_sample];
+        else section.sample_count++;
+
+        section.samples[section.next_sample] = milliseconds;
+        section.sample_sum += milliseconds;
+        section.next_sample = (section.next_sample + 1) % window_size;
+    }
+
+    double Gpu_Profiler::get_average_ms(const std::string& path) const
+    {
+        for (const Section_Timing& timing : get_timings())
+        {
+            if (timing.path == path) return timing.average_ms;
+        }
+
+        return -1.0;
+    }
+
+    std::vector<Gpu_Profiler::Section_Timing> Gpu_Profiler::get_timings() const
+    {
+        std::vector<Section_Timing> timings;
+        gather_timings(0, "", timings);
+        return timings;
+    }
+
+    void Gpu_Profiler::gather_timings(unsigned index, const std::string& parent_path, std::vector<Section_Timing>& timings) const
+    {
+        const Section& section = sections[index];
+
+        std::string path = parent_path.empty() ? section.name : parent_path + " > " + section.name;
+        double average = section.sample_count ? section.sample_sum / section.sample_count : 0.0;
+
+        timings.push_back(Section_Timing{ path, section.name, section.depth, average });
+
+        for (unsigned child : section.children)
+        {
+            gather_timings(child, path, timings);
+        }
+    }
+
+    void Gpu_Profiler::dump(std::ostream& out) const
+    {
+        // Se formatea aparte para no dejar fixed y la precisión puestos en el stream del llamador
+        std::ostringstream text;
+
+        text << "------------------------------------------------" << std::endl;
+        text << "GPU (media de " << window_size << " frames):" << std::endl;
+
+        for (const Section_Timing& timing : get_timings())
+        {
+            text << std::string(timing.depth * 2, ' ')
+                 << std::left << std::setw(40 - int(timing.depth * 2)) << timing.name
+                 << std::right << std::fixed << std::setprecision(3) << timing.average_ms << " ms" << std::endl;
+        }
+
+        text << "------------------------------------------------" << std::endl;
+
+        out << text.str() << std::flush;
+    }
+}
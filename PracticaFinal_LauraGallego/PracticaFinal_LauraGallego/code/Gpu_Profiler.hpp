@@ -0,0 +1,116 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+#include <glad/gl.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace udit
+{
+    // Medición del tiempo de GPU por secciones (pases y grupos de draws) mediante
+    // consultas GL_TIMESTAMP. Las consultas se reparten en un anillo de frames para
+    // leer resultados de frames ya terminados sin bloquear el pipeline.
+    class Gpu_Profiler
+    {
+    public:
+
+        static constexpr unsigned frames_in_flight = 4;
+        static constexpr unsigned window_size      = 60;        // Frames promediados
+
+        struct Section_Timing
+        {
+            std::string path;           // "frame > opaque > assets/cat.obj"
+            std::string name;
+            unsigned    depth;
+            double      average_ms;
+        };
+
+        // Mide la sección mientras el objeto está vivo
+        class Scope
+        {
+            Gpu_Profiler & profiler;
+
+        public:
+
+            Scope(Gpu_Profiler & profiler, const std::string & name) : profiler(profiler) { profiler.begin(name); }
+           ~Scope() { profiler.end(); }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+        };
+
+    private:
+
+        struct Section
+        {
+            std::string           name;
+            unsigned              depth;
+            std::vector<unsigned> children;
+
+            double   samples[window_size];
+            unsigned sample_count;
+            unsigned next_sample;
+            double   sample_sum;
+            double   frame_time;
+        };
+
+        struct Record
+        {
+            unsigned section;
+            GLuint   start_query;
+            GLuint   end_query;
+        };
+
+        struct Frame
+        {
+            std::vector<GLuint> queries;
+            size_t              used_queries = 0;
+            std::vector<Record> records;
+        };
+
+        Frame    frames[frames_in_flight];
+        unsigned current_frame;
+        bool     enabled;
+        bool     in_frame;
+
+        std::vector<Section>  sections;
+        std::vector<unsigned> stack;
+        std::vector<size_t>   open_records;
+
+    public:
+
+        Gpu_Profiler();
+       ~Gpu_Profiler();
+
+        Gpu_Profiler(const Gpu_Profiler&) = delete;
+        Gpu_Profiler& operator=(const Gpu_Profiler&) = delete;
+
+        void begin_frame();
+        void end_frame();
+
+        void begin(const std::string& name);
+        void end();
+
+        void set_enabled(bool value) { enabled = value; }
+        bool is_enabled() const { return enabled; }
+
+        // Media (ms) de la sección indicada por su ruta; negativo si no existe
+        double get_average_ms(const std::string& path) const;
+
+        // Todas las secciones en orden jerárquico (profundidad primero)
+        std::vector<Section_Timing> get_timings() const;
+
+        void dump(std::ostream& out) const;
+
+    private:
+
+        unsigned find_or_add_section(const std::string& name);
+        GLuint   acquire_query(Frame& frame);
+        void     collect(Frame& frame);
+        void     add_sample(Section& section, double milliseconds);
+        void     gather_timings(unsigned index, const std::string& parent_path, std::vector<Section_Timing>& timings) const;
+    };
+}
@@ -0,0 +1,294 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#include "Heightfield.hpp"
+#include "Thread_Pool.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+    #define UDIT_X86 1
+    #include <emmintrin.h>
+#endif
+
+namespace udit
+{
+    namespace
+    {
+        const float TEXEL_SCALE = 1.0f / 255.0f;
+
+        const size_t NORMAL_BAND_ROWS = 32;         // Filas por tarea del Sobel
+
+        // Componente ya multiplicada por 127 y dentro de [-127, 127]. Redondeo al par más
+        // cercano (el modo por defecto), igual que _mm_cvtps_epi32 en la ruta SSE2.
+        int8_t to_snorm8(float value)
+        {
+            return int8_t(std::nearbyint(value));
+        }
+    }
+
+    Heightfield::Heightfield(const unsigned char* pixels, int width, int height)
+        : texels(pixels, pixels + size_t(width) * height), width(width), height(height)
+    {
+    }
+
+    float Heightfield::sample(float u, float v) const
+    {
+        if (texels.empty()) return 0.0f;
+
+        // Centros de texel en (i + 0.5) / tamaño; fuera del mapa se repite el borde
+        float s = std::min(std::max(u * width  - 0.5f, 0.0f), float(width  - 1));
+        float t = std::min(std::max(v * height - 0.5f, 0.0f), float(height - 1));
+
+        int x0 = int(s), x1 = std::min(x0 + 1, width  - 1);
+        int y0 = int(t), y1 = std::min(y0 + 1, height - 1);
+
+        float fx = s - float(x0);
+        float fy = t - float(y0);
+
+        const uint8_t* row0 = &texels[size_t(y0) * width];
+        const uint8_t* row1 = &texels[size_t(y1) * width];
+
+        float top    = row0[x0] + (float(row0[x1]) - float(row0[x0])) * fx;
+        float bottom = row1[x0] + (float(row1[x1]) - float(row1[x0])) * fx;
+
+        return (top + (bottom - top) * fy) * TEXEL_SCALE;
+    }
+
+    void Heightfield::gradient(float u, float v, float& du, float& dv) const
+    {
+        float step_u = 1.0f / float(std::max(width,  1));
+        float step_v = 1.0f / float(std::max(height, 1));
+
+        du = (sample(u + step_u, v) - sample(u - step_u, v)) / (2.0f * step_u);
+        dv = (sample(u, v + step_v) - sample(u, v - step_v)) / (2.0f * step_v);
+    }
+
+    #ifdef UDIT_X86
+
+    namespace
+    {
+        // Cuatro muestras bilineales; s y t ya en texeles y dentro del mapa
+        __m128 bilinear4(const uint8_t* texels, int width, int height, __m128 s, __m128 t)
+        {
+            // Con s y t no negativos, truncar es redondear hacia abajo
+            __m128i x0 = _mm_cvttps_epi32(s);
+            __m128i y0 = _mm_cvttps_epi32(t);
+
+            __m128 fx = _mm_sub_ps(s, _mm_cvtepi32_ps(x0));
+            __m128 fy = _mm_sub_ps(t, _mm_cvtepi32_ps(y0));
+
+            alignas(16) int32_t xs[4], ys[4];
+            _mm_store_si128((__m128i*)xs, x0);
+            _mm_store_si128((__m128i*)ys, y0);
+
+            alignas(16) float t00[4], t10[4], t01[4], t11[4];
+
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                int x1 = std::min(xs[lane] + 1, width  - 1);
+                int y1 = std::min(ys[lane] + 1, height - 1);
+
+                const uint8_t* row0 = texels + size_t(ys[lane]) * width;
+                const uint8_t* row1 = texels + size_t(y1)       * width;
+
+                t00[lane] = row0[xs[lane]]; t10[lane] = row0[x1];
+                t01[lane] = row1[xs[lane]]; t11[lane] = row1[x1];
+            }
+
+            __m128 top    = _mm_add_ps(_mm_load_ps(t00), _mm_mul_ps(_mm_sub_ps(_mm_load_ps(t10), _mm_load_ps(t00)), fx));
+            __m128 bottom = _mm_add_ps(_mm_load_ps(t01), _mm_mul_ps(_mm_sub_ps(_mm_load_ps(t11), _mm_load_ps(t01)), fx));
+
+            return _mm_mul_ps(_mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), fy)), _mm_set1_ps(TEXEL_SCALE));
+        }
+
+        __m128 to_texels(__m128 coordinate, int size)
+        {
+            __m128 texel = _mm_sub_ps(_mm_mul_ps(coordinate, _mm_set1_ps(float(size))), _mm_set1_ps(0.5f));
+            return _mm_min_ps(_mm_max_ps(texel, _mm_setzero_ps()), _mm_set1_ps(float(size - 1)));
+        }
+    }
+
+    #endif
+
+    void Heightfield::sample(const float* u, const float* v, float* heights, size_t count) const
+    {
+        if (texels.empty())
+        {
+            std::fill(heights, heights + count, 0.0f);
+            return;
+        }
+
+        size_t i = 0;
+
+        #ifdef UDIT_X86
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 s = to_texels(_mm_loadu_ps(u + i), width );
+            __m128 t = to_texels(_mm_loadu_ps(v + i), height);
+
+            _mm_storeu_ps(heights + i, bilinear4(texels.data(), width, height, s, t));
+        }
+
+        #endif
+
+        for (; i < count; ++i) heights[i] = sample(u[i], v[i]);
+    }
+
+    void Heightfield::gradient(const float* u, const float* v, float* du, float* dv, size_t count) const
+    {
+        if (texels.empty())
+        {
+            std::fill(du, du + count, 0.0f);
+            std::fill(dv, dv + count, 0.0f);
+            return;
+        }
+
+        size_t i = 0;
+
+        #ifdef UDIT_X86
+
+        const float step_u = 1.0f / float(width);
+        const float step_v = 1.0f / float(height);
+
+        const __m128 offset_u = _mm_set1_ps(step_u);
+        const __m128 offset_v = _mm_set1_ps(step_v);
+        const __m128 scale_u  = _mm_set1_ps(1.0f / (2.0f * step_u));
+        const __m128 scale_v  = _mm_set1_ps(1.0f / (2.0f * step_v));
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 cu = _mm_loadu_ps(u + i);
+            __m128 cv = _mm_loadu_ps(v + i);
+
+            __m128 t  = to_texels(cv, height);
+            __m128 s  = to_texels(cu, width );
+
+            __m128 right = bilinear4(texels.data(), width, height, to_texels(_mm_add_ps(cu, offset_u), width), t);
+            __m128 left  = bilinear4(texels.data(), width, height, to_texels(_mm_sub_ps(cu, offset_u), width), t);
+            __m128 up    = bilinear4(texels.data(), width, height, s, to_texels(_mm_add_ps(cv, offset_v), height));
+            __m128 down  = bilinear4(texels.data(), width, height, s, to_texels(_mm_sub_ps(cv, offset_v), height));
+
+            _mm_storeu_ps(du + i, _mm_mul_ps(_mm_sub_ps(right, left), scale_u));
+            _mm_storeu_ps(dv + i, _mm_mul_ps(_mm_sub_ps(up,    down), scale_v));
+        }
+
+        #endif
+
+        for (; i < count; ++i) gradient(u[i], v[i], du[i], dv[i]);
+    }
+
+    void Heightfield::build_normal_map(float extent_x, float extent_y, float extent_z, std::vector<int8_t>& normals) const
+    {
+        normals.assign(texels.size() * 2, 0);
+
+        if (texels.empty()) return;
+
+        // Sobel da 8 veces la diferencia por texel en unidades de 0 a 255; se pasa a
+        // pendiente local (altura por unidad de distancia en el plano)
+        const float slope_x = extent_y * width  / (8.0f * 255.0f * extent_x);
+        const float slope_z = extent_y * height / (8.0f * 255.0f * extent_z);
+
+        const uint8_t* pixels = texels.data();
+        const int      w      = width;
+        const int      h      = height;
+
+        auto normal_at = [&] (const uint8_t* above, const uint8_t* row, const uint8_t* below, int x, int8_t* out)
+        {
+            int l = std::max(x - 1, 0), r = std::min(x + 1, w - 1);
+
+            int gx = (above[r] + 2 * row[r] + below[r]) - (above[l] + 2 * row[l] + below[l]);
+            int gz = (below[l] + 2 * below[x] + below[r]) - (above[l] + 2 * above[x] + above[r]);
+
+            float nx = -gx * slope_x;
+            float nz = -gz * slope_z;
+            // Misma expresión y mismo orden de operaciones que la ruta SSE2
+            float scale = 127.0f / std::sqrt((nx * nx + nz * nz) + 1.0f);
+
+            out[0] = to_snorm8(nx * scale);
+            out[1] = to_snorm8(nz * scale);
+        };
+
+        auto build_band = [&] (size_t band)
+        {
+            int first = int(band * NORMAL_BAND_ROWS);
+            int last  = std::min(first + int(NORMAL_BAND_ROWS), h);
+
+            for (int y = first; y < last; ++y)
+            {
+                const uint8_t* above = pixels + size_t(std::max(y - 1, 0    )) * w;
+                const uint8_t* row   = pixels + size_t(y)                      * w;
+                const uint8_t* below = pixels + size_t(std::min(y + 1, h - 1)) * w;
+
+                int8_t* out = normals.data() + size_t(y) * w * 2;
+                int     x   = 0;
+
+                normal_at(above, row, below, x++, out);
+
+                #ifdef UDIT_X86
+
+                // Ocho texeles por paso; las sumas de Sobel caben en 16 bits con signo
+                const __m128i zero  = _mm_setzero_si128();
+                const __m128  one   = _mm_set1_ps(1.0f);
+                const __m128  snorm = _mm_set1_ps(127.0f);
+                const __m128  sx    = _mm_set1_ps(-slope_x);
+                const __m128  sz    = _mm_set1_ps(-slope_z);
+
+                auto load = [&] (const uint8_t* source)
+                {
+                    return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)source), zero);
+                };
+
+                auto normalize_half = [&] (__m128i gx, __m128i gz, __m128i& out_x, __m128i& out_z)
+                {
+                    __m128 nx = _mm_mul_ps(_mm_cvtepi32_ps(gx), sx);
+                    __m128 nz = _mm_mul_ps(_mm_cvtepi32_ps(gz), sz);
+                    __m128 length  = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(nz, nz)), one));
+                    __m128 scale   = _mm_div_ps(snorm, length);
+
+                    out_x = _mm_cvtps_epi32(_mm_mul_ps(nx, scale));
+                    out_z = _mm_cvtps_epi32(_mm_mul_ps(nz, scale));
+                };
+
+                // Signo de 16 a 32 bits: unpack consigo mismo y desplazamiento aritmético
+                auto low32  = [] (__m128i v) { return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16); };
+                auto high32 = [] (__m128i v) { return _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16); };
+
+                for (; x + 9 <= w; x += 8)
+                {
+                    __m128i above_l = load(above + x - 1), above_c = load(above + x), above_r = load(above + x + 1);
+                    __m128i row_l   = load(row   + x - 1),                            row_r   = load(row   + x + 1);
+                    __m128i below_l = load(below + x - 1), below_c = load(below + x), below_r = load(below + x + 1);
+
+                    __m128i gx = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(above_r, below_r), _mm_slli_epi16(row_r, 1)),
+                                               _mm_add_epi16(_mm_add_epi16(above_l, below_l), _mm_slli_epi16(row_l, 1)));
+                    __m128i gz = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(below_l, below_r), _mm_slli_epi16(below_c, 1)),
+                                               _mm_add_epi16(_mm_add_epi16(above_l, above_r), _mm_slli_epi16(above_c, 1)));
+
+                    __m128i x_low, z_low, x_high, z_high;
+
+                    normalize_half(low32 (gx), low32 (gz), x_low,  z_low );
+                    normalize_half(high32(gx), high32(gz), x_high, z_high);
+
+                    __m128i nx = _mm_packs_epi32(x_low, x_high);
+                    __m128i nz = _mm_packs_epi32(z_low, z_high);
+
+                    // Intercalado x, z en bytes: 16 bytes para los ocho texeles
+                    __m128i packed = _mm_unpacklo_epi8(_mm_packs_epi16(nx, zero), _mm_packs_epi16(nz, zero));
+
+                    _mm_storeu_si128((__m128i*)(out + size_t(x) * 2), packed);
+                }
+
+                #endif
+
+                for (; x < w; ++x) normal_at(above, row, below, x, out + size_t(x) * 2);
+            }
+        };
+
+        size_t bands = (size_t(h) + NORMAL_BAND_ROWS - 1) / NORMAL_BAND_ROWS;
+
+        if (bands > 1) Thread_Pool::instance().parallel_for(bands, build_band);
+        else build_band(0);
+    }
+}
@@ -0,0 +1,60 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace udit
+{
+    // Copia en la CPU de un mapa de alturas de 8 bits (un byte por texel, como en la GPU).
+    // Las consultas usan coordenadas de textura en [0, 1] y el mismo filtrado que
+    // GL_LINEAR con GL_CLAMP_TO_EDGE, así que coinciden con lo que lee el vertex shader.
+    // Las alturas devueltas están normalizadas en [0, 1].
+    //
+    // Las variantes por lotes procesan cuatro consultas a la vez con SSE2 cuando está
+    // disponible; los texeles se leen uno a uno (SSE2 no tiene gather).
+    class Heightfield
+    {
+    private:
+
+        std::vector<uint8_t> texels;
+        int                  width;
+        int                  height;
+
+    public:
+
+        Heightfield() : width(0), height(0) {}
+        Heightfield(const unsigned char* pixels, int width, int height);
+
+        bool empty() const { return texels.empty(); }
+
+        void swap(Heightfield& other)
+        {
+            texels.swap(other.texels);
+            std::swap(width,  other.width );
+            std::swap(height, other.height);
+        }
+
+        int            get_width () const { return width;         }
+        int            get_height() const { return height;        }
+        const uint8_t* data      () const { return texels.data(); }
+
+        float sample(float u, float v) const;
+
+        // Derivadas de la altura respecto a u y v (diferencias centrales de un texel)
+        void gradient(float u, float v, float& du, float& dv) const;
+
+        void sample  (const float* u, const float* v, float* heights, size_t count) const;
+        void gradient(const float* u, const float* v, float* du, float* dv, size_t count) const;
+
+        // Mapa de normales del mismo tamaño (Sobel 3x3, borde repetido) para un terreno que
+        // cubre extent_x por extent_z con una altura máxima extent_y. Guarda las
+        // componentes x y z de la normal local como pares RG en formato snorm de 8 bits;
+        // la y se reconstruye en el shader porque siempre es positiva.
+        void build_normal_map(float extent_x, float extent_y, float extent_z, std::vector<int8_t>& normals) const;
+    };
+}
@@ -0,0 +1,266 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#include "Instanced_Renderer.hpp"
+#include "Frame_Uniforms.hpp"
+#include "Mesh.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <gtc/type_ptr.hpp>
+
+namespace udit
+{
+    namespace
+    {
+        // Los atributos 0..2 son los de Geometry; cada columna de matriz ocupa una posición
+        const GLuint MODEL_ATTRIBUTE         = 3;
+        const GLuint NORMAL_MATRIX_ATTRIBUTE = 7;
+        const GLuint PARAMETERS_ATTRIBUTE    = 10;
+    }
+
+    Instanced_Renderer::Instanced_Renderer()
+        : depth_scale_loc(-1), depth_offset_loc(-1), instance_buffer(0), instance_capacity(0), draw_count(0), instance_count(0)
+    {
+        glGenBuffers(1, &instance_buffer);
+
+        compile_shaders();
+    }
+
+    Instanced_Renderer::~Instanced_Renderer()
+    {
+        glDeleteBuffers(1, &instance_buffer);
+    }
+
+    void Instanced_Renderer::upload()
+    {
+        UDIT_TRACE_SCOPE("Instanced_Renderer::upload");
+
+        instances.clear();
+        batches  .clear();
+
+        if (queue.empty()) return;
+
+        // Agrupación: las mallas con el mismo estado quedan contiguas, y las de un mismo
+        // buffer de geometría seguidas para enlazar su VAO una sola vez
+        auto vao_of = [] (const Mesh* mesh) { return mesh->get_geometry() ? mesh->get_geometry()->get_vao() : 0u; };
+
+        std::sort(queue.begin(), queue.end(), [&vao_of] (const Mesh* a, const Mesh* b)
+        {
+            return std::make_tuple(vao_of(a), a->get_geometry(), a->get_lod(), a->get_texture())
+                 < std::make_tuple(vao_of(b), b->get_geometry(), b->get_lod(), b->get_texture());
+        });
+
+        for (const Mesh* mesh : queue)
+        {
+            if (!mesh->get_geometry()) continue;
+
+            if (batches.empty()
+                || batches.back().geometry != mesh->get_geometry()
+                || batches.back().lod      != mesh->get_lod     ()
+                || batches.back().texture  != mesh->get_texture ())
+            {
+                batches.push_back({ mesh->get_geometry(), mesh->get_texture(), mesh->get_lod(), instances.size(), 0 });
+            }
+
+            const glm::mat4& normal_matrix = mesh->get_normal_matrix();
+
+            instances.push_back({ mesh->get_global_matrix(), { normal_matrix[0], normal_matrix[1], normal_matrix[2] }, glm::vec4(mesh->get_opacity(), 0.0f, 0.0f, 0.0f) });
+            batches.back().count++;
+        }
+
+        // Subida de todas las instancias; se reserva almacenamiento nuevo (orphaning) para no esperar a la GPU
+        glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+
+        if (instances.size() > instance_capacity) {
+            instance_capacity = std::max(instances.size(), instance_capacity * 2);
+        }
+
+        glBufferData   (GL_ARRAY_BUFFER, instance_capacity * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(Instance), instances.data());
+    }
+
+    void Instanced_Renderer::draw(bool depth_only)
+    {
+        UDIT_TRACE_SCOPE("Instanced_Renderer::draw");
+
+        draw_count     = 0;
+        instance_count = 0;
+
+        if (batches.empty()) return;
+
+        glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+
+        glUseProgram(depth_only ? depth_program->get_id() : program->get_id());
+
+        GLint batch_scale_loc  = depth_only ? depth_scale_loc  : scale_loc;
+        GLint batch_offset_loc = depth_only ? depth_offset_loc : offset_loc;
+
+        if (!depth_only) {
+            glUniform1i(texture_loc, 0);
+            glActiveTexture(GL_TEXTURE0);
+        }
+
+        GLuint bound_vao = 0;
+
+        for (const Batch& batch : batches)
+        {
+            if (!depth_only) glBindTexture(GL_TEXTURE_2D, batch.texture ? batch.texture->get_id() : 0);
+
+            glUniform3fv(batch_scale_loc,  1, glm::value_ptr(batch.geometry->get_position_scale()));
+            glUniform3fv(batch_offset_loc, 1, glm::value_ptr(batch.geometry->get_position_offset()));
+
+            if (batch.geometry->get_vao() != bound_vao) {
+                bound_vao = batch.geometry->get_vao();
+                glBindVertexArray(bound_vao);
+            }
+
+            bind_instance_attributes(batch.first);
+
+            batch.geometry->draw_instanced(GLsizei(batch.count), batch.lod);
+
+            draw_count     += 1;
+            instance_count += batch.count;
+        }
+
+        glBindVertexArray(0);
+    }
+
+    void Instanced_Renderer::bind_instance_attributes(size_t first_instance)
+    {
+        // Sin glDrawElementsInstancedBaseInstance (GL 4.2) el primer elemento del lote se
+        // indica desplazando los punteros de atributo
+        size_t offset = first_instance * sizeof(Instance);
+
+        for (GLuint column = 0; column < 4; ++column)
+        {
+            glEnableVertexAttribArray(MODEL_ATTRIBUTE + column);
+            glVertexAttribPointer(MODEL_ATTRIBUTE + column, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(offset + column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(MODEL_ATTRIBUTE + column, 1);
+        }
+
+        for (GLuint column = 0; column < 3; ++column)
+        {
+            glEnableVertexAttribArray(NORMAL_MATRIX_ATTRIBUTE + column);
+            glVertexAttribPointer(NORMAL_MATRIX_ATTRIBUTE + column, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(offset + offsetof(Instance, normal_matrix) + column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(NORMAL_MATRIX_ATTRIBUTE + column, 1);
+        }
+
+        glEnableVertexAttribArray(PARAMETERS_ATTRIBUTE);
+        glVertexAttribPointer(PARAMETERS_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(offset + offsetof(Instance, parameters)));
+        glVertexAttribDivisor(PARAMETERS_ATTRIBUTE, 1);
+    }
+
+    void Instanced_Renderer::compile_shaders()
+    {
+        std::string vShaderCode = std::string("#version 330 core\n") + Frame_Uniforms::FRAME_BLOCK + R"(
+        layout (location = 0) in vec3 aPos;
+        layout (location = 1) in vec3 aNormal;
+        layout (location = 2) in vec2 aTexCoords;
+        layout (location = 3) in mat4 aModel;         // Por instancia (ocupa 3..6)
+        layout (location = 7) in mat3 aNormalMatrix;  // Por instancia (ocupa 7..9)
+        layout (location = 10) in vec4 aParameters;   // Por instancia: x = opacidad
+
+        out vec3 Normal;
+        out vec3 FragPos;
+        out vec2 TexCoords;
+        out float Alpha;
+
+        // Reconstrucción de posiciones cuantizadas (escala 1 y origen 0 en formato completo)
+        uniform vec3 position_scale;
+        uniform vec3 position_offset;
+
+        // Misma posición exacta que en el pre-pase de profundidad
+        invariant gl_Position;
+
+        void main()
+        {
+            FragPos = vec3(aModel * vec4(aPos * position_scale + position_offset, 1.0));
+            Normal = aNormalMatrix * aNormal;
+            TexCoords = aTexCoords;
+            Alpha = aParameters.x;
+            gl_Position = view_projection * vec4(FragPos, 1.0);
+        }
+    )";
+
+        std::string fShaderCode = std::string("#version 330 core\n") + Frame_Uniforms::FRAME_BLOCK + R"(
+        out vec4 FragColor;
+
+        in vec3 Normal;
+        in vec3 FragPos;
+        in vec2 TexCoords;
+        in float Alpha;
+
+        uniform sampler2D texture1;
+
+        void main()
+        {
+            vec3 objectColor = texture(texture1, TexCoords).rgb;
+
+            vec3 lightColor = light_color.rgb;
+
+            // Ambiente
+            float ambientStrength = 0.5;
+            vec3 ambient = ambientStrength * lightColor;
+
+            // Difusa
+            vec3 norm = normalize(Normal);
+            vec3 lightDir = normalize(light_position.xyz - FragPos);
+            float diff = max(dot(norm, lightDir), 0.0);
+            vec3 diffuse = diff * lightColor;
+
+            // Especular
+            float specularStrength = 0.5;
+            vec3 viewDir = normalize(camera_position.xyz - FragPos);
+            vec3 reflectDir = reflect(-lightDir, norm);
+            float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+            vec3 specular = specularStrength * spec * lightColor;
+
+            vec3 result = (ambient + diffuse + specular) * objectColor;
+            FragColor = vec4(result, Alpha);
+        }
+    )";
+
+        program = Resource_Cache::instance().get_program(vShaderCode.c_str(), fShaderCode.c_str());
+
+        GLuint shader_program_id = program->get_id();
+
+        Frame_Uniforms::bind_blocks(shader_program_id);
+
+        texture_loc     = glGetUniformLocation(shader_program_id, "texture1");
+        scale_loc       = glGetUniformLocation(shader_program_id, "position_scale");
+        offset_loc      = glGetUniformLocation(shader_program_id, "position_offset");
+
+        // Pre-pase de profundidad: posición y matriz model por instancia, nada más
+        std::string vDepthCode = std::string("#version 330 core\n") + Frame_Uniforms::FRAME_BLOCK + R"(
+        layout (location = 0) in vec3 aPos;
+        layout (location = 3) in mat4 aModel;
+
+        uniform vec3 position_scale;
+        uniform vec3 position_offset;
+
+        invariant gl_Position;
+
+        void main()
+        {
+            vec3 FragPos = vec3(aModel * vec4(aPos * position_scale + position_offset, 1.0));
+            gl_Position = view_projection * vec4(FragPos, 1.0);
+        }
+    )";
+
+        std::string fDepthCode = R"(
+        #version 330 core
+        void main() {}
+    )";
+
+        depth_program = Resource_Cache::instance().get_program(vDepthCode.c_str(), fDepthCode.c_str());
+
+        GLuint depth_program_id = depth_program->get_id();
+
+        Frame_Uniforms::bind_blocks(depth_program_id);
+
+        depth_scale_loc  = glGetUniformLocation(depth_program_id, "position_scale");
+        depth_offset_loc = glGetUniformLocation(depth_program_id, "position_offset");
+    }
+}
@@ -0,0 +1,84 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+#include "Resource_Cache.hpp"
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <glad/gl.h>
+#include <glm.hpp>
+
+namespace udit
+{
+    class Mesh;
+
+    // Dibuja con glDrawElementsInstanced las mallas que comparten geometría, nivel de
+    // detalle y textura. Las matrices model y de normales y la opacidad de cada malla
+    // viajan en un buffer de instancias que se rellena en cada flush; cámara y luz, en
+    // el bloque Frame de Frame_Uniforms.
+    class Instanced_Renderer
+    {
+    private:
+
+        struct Instance
+        {
+            glm::mat4 model;
+            glm::vec4 normal_matrix[3];         // Columnas de la mat3 de normales
+            glm::vec4 parameters;               // x = opacidad
+        };
+
+        struct Batch
+        {
+            const Geometry* geometry;
+            const Texture*  texture;
+            size_t          lod;
+            size_t          first;
+            size_t          count;
+        };
+
+        std::shared_ptr<Shader_Program> program;
+        GLint texture_loc, scale_loc, offset_loc;
+
+        std::shared_ptr<Shader_Program> depth_program;      // Solo posiciones, para el pre-pase
+        GLint depth_scale_loc, depth_offset_loc;
+
+        GLuint instance_buffer;
+        size_t instance_capacity;
+
+        std::vector<const Mesh*> queue;
+        std::vector<Instance>    instances;
+        std::vector<Batch>       batches;
+
+        size_t draw_count;                      // Llamadas de dibujo del último flush
+        size_t instance_count;
+
+    public:
+
+        Instanced_Renderer();
+       ~Instanced_Renderer();
+
+        Instanced_Renderer(const Instanced_Renderer&) = delete;
+        Instanced_Renderer& operator=(const Instanced_Renderer&) = delete;
+
+        void begin() { queue.clear(); }
+        void add  (const Mesh& mesh) { queue.push_back(&mesh); }
+
+        // Agrupa lo encolado desde begin() y sube las instancias
+        void upload();
+
+        // Un lote por grupo con lo subido en upload(); con depth_only solo escribe profundidad
+        void draw(bool depth_only = false);
+
+        void flush() { upload(); draw(); }
+
+        size_t get_draw_count    () const { return draw_count;     }
+        size_t get_instance_count() const { return instance_count; }
+
+    private:
+
+        void compile_shaders();
+        void bind_instance_attributes(size_t first_instance);
+    };
+}
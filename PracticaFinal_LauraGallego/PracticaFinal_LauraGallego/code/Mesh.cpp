@@ -1,200 +1,119 @@
-// Este cdigo es de dominio pblico
+// Este código es de dominio público
 // penterrin@gmail.com
 
 #include "Mesh.hpp"
 #include "Camera.hpp"
-#include <SOIL2.h>
+#include "Trace.hpp"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <gtc/type_ptr.hpp>
 
 
 namespace udit
 {
-    Mesh::Mesh(const std::string& path) : opacity(1.0f), light_ptr(nullptr)
+    Mesh::Mesh(const std::string& path, Vertex_Format format) : opacity(1.0f), lod(0), source_path(path), world_sphere_version(~0u), normal_matrix_version(~0u)
     {
-        // Uso de Assimp para carga y normalizacin del modelo
-        Assimp::Importer importer;
-        
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals);
-
-        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
-        {
-            std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
-            return;
-        }
-
-        std::cout << "------------------------------------------------" << std::endl;
-        std::cout << "EXITO: Modelo encontrado: " << path << std::endl;
-
-
-        
-        process_node(scene->mRootNode, scene);
-
-        std::cout << "INFO: Se han cargado " << vertices.size() << " vertices." << std::endl;
-        if (vertices.size() == 0) std::cout << "ALERTA: El modelo esta vacio!" << std::endl;
-        std::cout << "------------------------------------------------" << std::endl;
-        
+        UDIT_TRACE_SCOPE("Mesh::Mesh");
 
-       
-        setup_mesh();
+        Resource_Cache& cache = Resource_Cache::instance();
 
-        // Carga manual de textura mediante librera SOIL
-        texture_id = SOIL_load_OGL_texture(
-            "assets/cat.png",  
-            SOIL_LOAD_AUTO,
-            SOIL_CREATE_NEW_ID,
-            SOIL_FLAG_MIPMAPS /*| SOIL_FLAG_INVERT_Y*/
-        );
-
-        if (texture_id == 0) {
-            std::cout << "ERROR: No se pudo cargar la textura del gato (assets/cat.jpg)" << std::endl;
-        }
         compile_shaders();
+
+        // Las mallas del mismo archivo comparten buffers, textura y programa. Geometría y
+        // textura llegan de forma asíncrona; sin geometría la malla no se dibuja.
+        cache.request_geometry(path, format, [this] (const std::shared_ptr<Geometry>& loaded) { geometry = loaded; });
+        cache.request_texture ("assets/cat.png", [this] (const std::shared_ptr<Texture>& loaded) { texture = loaded; });
     }
 
     Mesh::~Mesh()
     {
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
-        glDeleteBuffers(1, &EBO);
-        glDeleteProgram(shader_program_id);
+        // Los recursos compartidos se liberan con la última malla que los referencia
     }
 
-    void Mesh::process_node(aiNode* node, const aiScene* scene)
+    bool Mesh::get_local_bounds(Aabb& bounds) const
     {
-        
-        for (unsigned int i = 0; i < node->mNumMeshes; i++)
-        {
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            process_mesh(mesh, scene);
-        }
-        
-        for (unsigned int i = 0; i < node->mNumChildren; i++)
-        {
-            process_node(node->mChildren[i], scene);
+        if (!geometry) return false;
+
+        bounds = geometry->get_local_bounds();
+        return true;
+    }
+
+    const Sphere& Mesh::get_world_sphere() const
+    {
+        if (geometry && world_sphere_version != get_world_version()) {
+            world_sphere = geometry->get_local_sphere().transformed(get_global_matrix());
+            world_sphere_version = get_world_version();
         }
+
+        return world_sphere;
     }
 
-    void Mesh::process_mesh(aiMesh* mesh, const aiScene* scene)
+    void Mesh::update_lod(const Camera& camera, float viewport_height, float max_error_pixels)
     {
-        // Recorrido de todos los vrtices del modelo importado
-        for (unsigned int i = 0; i < mesh->mNumVertices; i++)
-        {
-            Vertex vertex;
-            
-            // Copia de posiciones
-            vertex.Position.x = mesh->mVertices[i].x;
-            vertex.Position.y = mesh->mVertices[i].y;
-            vertex.Position.z = mesh->mVertices[i].z;
+        if (!geometry) return;
 
-            // Copia de normales si existen
-            if (mesh->HasNormals())
-            {
-                vertex.Normal.x = mesh->mNormals[i].x;
-                vertex.Normal.y = mesh->mNormals[i].y;
-                vertex.Normal.z = mesh->mNormals[i].z;
-            }
-            else vertex.Normal = glm::vec3(0.0f, 1.0f, 0.0f);
+        // Distancia al punto más cercano de la esfera, para no quedarse corto en mallas grandes
+        const Sphere& sphere = get_world_sphere();
+        glm::vec3     eye    = glm::vec3(camera.get_location());
+        float         distance = std::max(glm::length(sphere.center - eye) - sphere.radius, camera.get_near_z());
 
-            // Copia de coordenadas de textura
-            if (mesh->mTextureCoords[0])
-            {
-                vertex.TexCoords.x = mesh->mTextureCoords[0][i].x;
-                vertex.TexCoords.y = mesh->mTextureCoords[0][i].y;
-            }
-            else
-            {
-                vertex.TexCoords = glm::vec2(0.0f, 0.0f);
-            }
+        // El error de los niveles está en unidades del modelo: se lleva a mundo con la escala
+        float local_radius = geometry->get_local_sphere().radius;
+        float scale        = local_radius > 0.0f ? sphere.radius / local_radius : 1.0f;
 
-            vertices.push_back(vertex);
-        }
+        float pixels_per_unit = viewport_height / (2.0f * std::tan(glm::radians(camera.get_fov()) * 0.5f)) * scale / distance;
 
-        // Copia de ndices para formacin de tringulos
-        for (unsigned int i = 0; i < mesh->mNumFaces; i++)
-        {
-            aiFace face = mesh->mFaces[i];
-            for (unsigned int j = 0; j < face.mNumIndices; j++)
-                indices.push_back(face.mIndices[j]);
-        }
+        lod = geometry->select_lod(lod, pixels_per_unit, max_error_pixels);
     }
 
-    void Mesh::setup_mesh()
+    const glm::mat4& Mesh::get_normal_matrix() const
     {
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-
-        
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+        if (normal_matrix_version != get_world_version()) {
+            normal_matrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(get_global_matrix()))));
+            normal_matrix_version = get_world_version();
+        }
 
-        
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        return normal_matrix;
+    }
 
-        
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    Frame_Uniforms::Object Mesh::get_object_data() const
+    {
+        Frame_Uniforms::Object object;
 
-        
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+        object.model         = get_global_matrix();
+        object.normal_matrix = get_normal_matrix();
+        object.parameters    = glm::vec4(opacity, 0.0f, 0.0f, 0.0f);
 
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+        object.position_scale  = glm::vec4(geometry ? geometry->get_position_scale () : glm::vec3(1.0f), 0.0f);
+        object.position_offset = glm::vec4(geometry ? geometry->get_position_offset() : glm::vec3(0.0f), 0.0f);
 
-        glBindVertexArray(0);
+        return object;
     }
 
     void Mesh::render(const Camera& camera)
     {
-        glUseProgram(shader_program_id);
-
-        glUniformMatrix4fv(proj_loc, 1, GL_FALSE, glm::value_ptr(camera.get_projection_matrix()));
-        glUniformMatrix4fv(view_loc, 1, GL_FALSE, glm::value_ptr(camera.get_transform_matrix_inverse()));
-        glUniformMatrix4fv(model_loc, 1, GL_FALSE, glm::value_ptr(get_global_matrix()));
+        UDIT_TRACE_SCOPE("Mesh::render");
 
-        // Envo de posicin de cmara para clculo especular
-        glm::vec4 camPos = camera.get_location();
-        glUniform3f(glGetUniformLocation(shader_program_id, "viewPos"), camPos.x, camPos.y, camPos.z);
+        if (!geometry) return;
 
-        // Configuracin de opacidad
-        glUniform1f(glGetUniformLocation(shader_program_id, "alpha"), opacity);
+        // Cámara y luz llegan en el bloque Frame; matrices y opacidad, en el rango de la malla
+        glUseProgram(program->get_id());
 
-        // Envo de datos de luz si existe asignacin; si no, valores por defecto
-        if (light_ptr)
-        {
-            glm::vec3 l_pos = light_ptr->get_position();
-            glm::vec3 l_col = light_ptr->get_color();
-
-            glUniform3f(glGetUniformLocation(shader_program_id, "lightPos"), l_pos.x, l_pos.y, l_pos.z);
-            glUniform3f(glGetUniformLocation(shader_program_id, "lightColor"), l_col.x, l_col.y, l_col.z);
-        }
-        else
-        {
-            
-            glUniform3f(glGetUniformLocation(shader_program_id, "lightPos"), 5.0f, 50.0f, 5.0f);
-            glUniform3f(glGetUniformLocation(shader_program_id, "lightColor"), 1.0f, 1.0f, 1.0f);
-        }
+        Frame_Uniforms::bind_object(object_slot);
 
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture_id);
+        glBindTexture(GL_TEXTURE_2D, texture ? texture->get_id() : 0);
 
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        geometry->draw(lod);
 
         Node::render(camera);
     }
 
     void Mesh::compile_shaders()
     {
-        
-        const char* vShaderCode = R"(
-        #version 330 core
+        // Bloques Frame y Object compartidos (ver Frame_Uniforms)
+        std::string vShaderCode = std::string("#version 330 core\n") + Frame_Uniforms::FRAME_BLOCK + Frame_Uniforms::OBJECT_BLOCK + R"(
         layout (location = 0) in vec3 aPos;
         layout (location = 1) in vec3 aNormal;
         layout (location = 2) in vec2 aTexCoords; // <--- NUEVO: Coordenadas UV del modelo
@@ -203,41 +122,36 @@ namespace udit
         out vec3 FragPos;
         out vec2 TexCoords; // <--- NUEVO: Se lo pasamos al fragment
 
-        uniform mat4 model;
-        uniform mat4 view;
-        uniform mat4 projection;
+        // Misma posición exacta que en el pre-pase de profundidad
+        invariant gl_Position;
 
         void main()
         {
-            FragPos = vec3(model * vec4(aPos, 1.0));
-            Normal = mat3(transpose(inverse(model))) * aNormal;  
+            // Reconstrucción de posiciones cuantizadas (escala 1 y origen 0 en formato completo)
+            FragPos = vec3(model * vec4(aPos * position_scale.xyz + position_offset.xyz, 1.0));
+            Normal = mat3(normal_matrix) * aNormal;
             TexCoords = aTexCoords; // <--- Pasamos la coordenada
-            gl_Position = projection * view * vec4(FragPos, 1.0);
+            gl_Position = view_projection * vec4(FragPos, 1.0);
         }
     )";
 
         
-        const char* fShaderCode = R"(
-        #version 330 core
-        out vec4 FragColor;
+        std::string fShaderCode = std::string("#version 330 core\n") + Frame_Uniforms::FRAME_BLOCK + Frame_Uniforms::OBJECT_BLOCK + R"(
+        layout (location = 0) out vec4  FragColor;
+        layout (location = 1) out float Weight;     // Solo en transparencia OIT (parameters.y = 1)
 
         in vec3 Normal;
         in vec3 FragPos;
         in vec2 TexCoords; // <--- Recibimos coordenadas
 
-        uniform vec3 viewPos;
         uniform sampler2D texture1; // <--- La imagen del gato
-        uniform float alpha;
-        
-        uniform vec3 lightPos;
-        uniform vec3 lightColor;
 
         void main()
         {
             // Leemos el color de la textura en este punto
             vec3 objectColor = texture(texture1, TexCoords).rgb;
 
-            
+            vec3 lightColor = light_color.rgb;
 
             // Ambiente
             float ambientStrength = 0.5;
@@ -245,34 +159,65 @@ namespace udit
   
             // Difusa
             vec3 norm = normalize(Normal);
-            vec3 lightDir = normalize(lightPos - FragPos);
+            vec3 lightDir = normalize(light_position.xyz - FragPos);
             float diff = max(dot(norm, lightDir), 0.0);
             vec3 diffuse = diff * lightColor;
             
             // Especular (Brillo)
             float specularStrength = 0.5; // Un poco menos brillo para que no parezca mojado
-            vec3 viewDir = normalize(viewPos - FragPos);
+            vec3 viewDir = normalize(camera_position.xyz - FragPos);
             vec3 reflectDir = reflect(-lightDir, norm);  
             float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32); 
             vec3 specular = specularStrength * spec * lightColor;  
                 
             // Multiplicamos la luz por el color de la textura
             vec3 result = (ambient + diffuse + specular) * objectColor;
-            FragColor = vec4(result, alpha);
+
+            float alpha = parameters.x;
+
+            if (parameters.y > 0.5)
+            {
+                // Weighted blended OIT (McGuire y Bavoil): color premultiplicado y ponderado
+                // por profundidad en rgb, opacidad en a para el producto de revelado
+                float z = abs((view * vec4(FragPos, 1.0)).z);
+                float w = alpha * clamp(10.0 / (1e-5 + pow(z / 5.0, 2.0) + pow(z / 200.0, 6.0)), 1e-2, 3e3);
+
+                FragColor = vec4(result * alpha * w, alpha);
+                Weight    = alpha * w;
+            }
+            else
+            {
+                FragColor = vec4(result, alpha);
+                Weight    = 0.0;
+            }
         }
     )";
 
-        
-        GLuint v = glCreateShader(GL_VERTEX_SHADER); glShaderSource(v, 1, &vShaderCode, NULL); glCompileShader(v);
-        GLuint f = glCreateShader(GL_FRAGMENT_SHADER); glShaderSource(f, 1, &fShaderCode, NULL); glCompileShader(f);
-        shader_program_id = glCreateProgram();
-        glAttachShader(shader_program_id, v); glAttachShader(shader_program_id, f); glLinkProgram(shader_program_id);
-        glDeleteShader(v); glDeleteShader(f);
-
-        model_loc = glGetUniformLocation(shader_program_id, "model");
-        view_loc = glGetUniformLocation(shader_program_id, "view");
-        proj_loc = glGetUniformLocation(shader_program_id, "projection");
-        viewPos_loc = glGetUniformLocation(shader_program_id, "viewPos");
-        
+        // Todas las mallas comparten el mismo programa enlazado
+        program = Resource_Cache::instance().get_program(vShaderCode.c_str(), fShaderCode.c_str());
+
+        Frame_Uniforms::bind_blocks(program->get_id());
+
+        // Pre-pase de profundidad: solo lee la posición y calcula gl_Position igual que arriba
+        std::string vDepthCode = std::string("#version 330 core\n") + Frame_Uniforms::FRAME_BLOCK + Frame_Uniforms::OBJECT_BLOCK + R"(
+        layout (location = 0) in vec3 aPos;
+
+        invariant gl_Position;
+
+        void main()
+        {
+            vec3 FragPos = vec3(model * vec4(aPos * position_scale.xyz + position_offset.xyz, 1.0));
+            gl_Position = view_projection * vec4(FragPos, 1.0);
+        }
+    )";
+
+        std::string fDepthCode = R"(
+        #version 330 core
+        void main() {}
+    )";
+
+        depth_program = Resource_Cache::instance().get_program(vDepthCode.c_str(), fDepthCode.c_str());
+
+        Frame_Uniforms::bind_blocks(depth_program->get_id());
     }
-}
\ No newline at end of file
+}
@@ -1,65 +1,85 @@
-// Este cdigo es de dominio pblico
+// Este código es de dominio público
 // penterrin@gmail.com
 
 #pragma once
 
 #include "Node.hpp"
-#include "Light.hpp"
-#include <vector>
+#include "Frame_Uniforms.hpp"
+#include "Resource_Cache.hpp"
+#include <memory>
 #include <string>
 #include <glad/gl.h>
 #include <glm.hpp>
 
-
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
-
 namespace udit
 {
     class Mesh : public Node
     {
     private:
-        
-        struct Vertex {
-            glm::vec3 Position;
-            glm::vec3 Normal;
-            glm::vec2 TexCoords; 
-        };
 
+        // Recursos compartidos con el resto de mallas del mismo modelo
+        std::shared_ptr<Geometry>       geometry;
+        std::shared_ptr<Texture>        texture;
+        std::shared_ptr<Shader_Program> program;
+        std::shared_ptr<Shader_Program> depth_program;      // Solo posiciones, para el pre-pase de profundidad
 
+        float opacity;
 
-        
-        std::vector<Vertex> vertices;
-        std::vector<unsigned int> indices;
+        size_t lod;                         // Nivel de detalle elegido en el último update_lod
 
-        
-        GLuint VAO, VBO, EBO;
-        GLuint shader_program_id;
-        GLuint texture_id;        
-        GLint model_loc, view_loc, proj_loc, color_loc, viewPos_loc;
+        std::string source_path;
 
-        float opacity;
+        mutable Sphere    world_sphere;     // Caché de la esfera en mundo
+        mutable unsigned  world_sphere_version;
 
-        void setup_mesh();
-        void compile_shaders();
-        void process_node(aiNode* node, const aiScene* scene);
-        void process_mesh(aiMesh* mesh, const aiScene* scene);
+        mutable glm::mat4 normal_matrix;    // Caché de la matriz de normales
+        mutable unsigned  normal_matrix_version;
 
-        Light* light_ptr;
+        Frame_Uniforms::Object_Slot object_slot;
+
+        void compile_shaders();
 
     public:
         
-        Mesh(const std::string& path);
+        // La malla debe seguir viva hasta que terminen sus cargas (Scene espera en su destructor)
+        Mesh(const std::string& path, Vertex_Format format = Vertex_Format::COMPACT);
         ~Mesh();
 
         float get_opacity() const { return opacity; }
 
+        const std::string& get_path() const { return source_path; }
+
         void set_opacity(float val) { opacity = val; }
+
+        virtual bool get_local_bounds(Aabb& bounds) const override;
+
+        // Esfera envolvente en mundo; solo se recalcula cuando cambia la matriz global
+        const Sphere& get_world_sphere() const;
        
+        // Elige el nivel de detalle cuyo error proyectado en pantalla no supere
+        // max_error_pixels a la distancia actual de la cámara
+        void update_lod(const Camera& camera, float viewport_height, float max_error_pixels);
+
+        void   reset_lod()       { lod = 0;    }
+        size_t get_lod  () const { return lod; }
+
+        // Inversa traspuesta de la matriz global; solo se recalcula cuando esta cambia
+        const glm::mat4& get_normal_matrix() const;
+
+        // Bloque Object de la malla para el frame actual y el rango donde se subió
+        Frame_Uniforms::Object get_object_data() const;
+        void                   set_object_slot(const Frame_Uniforms::Object_Slot& slot) { object_slot = slot; }
+
+        const Frame_Uniforms::Object_Slot& get_object_slot() const { return object_slot; }
+
         virtual void render(const Camera& camera) override;
 
-        void set_light(Light* l) { light_ptr = l; }
+        // Datos que agrupan las mallas en lotes instanciados
+        const Geometry*  get_geometry() const { return geometry.get(); }
+        const Texture*   get_texture () const { return texture.get();  }
+
+        const Shader_Program* get_program      () const { return program.get();       }
+        const Shader_Program* get_depth_program() const { return depth_program.get(); }
      
     };
 }
\ No newline at end of file
@@ -0,0 +1,290 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#include "Mesh_Cache.hpp"
+#include "Trace.hpp"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace udit
+{
+    // ---- Mapped_File ----------------------------------------------------------------------------
+
+    #ifdef _WIN32
+
+    Mapped_File::Mapped_File(const std::string& path) : data(nullptr), size(0), file_handle(INVALID_HANDLE_VALUE), mapping_handle(nullptr)
+    {
+        file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file_handle == INVALID_HANDLE_VALUE) return;
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0) return;
+
+        mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping_handle) return;
+
+        data = static_cast<const uint8_t*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+        size = data ? size_t(file_size.QuadPart) : 0;
+    }
+
+    Mapped_File::~Mapped_File()
+    {
+        if (data) UnmapViewOfFile(data);
+        if (mapping_handle) CloseHandle(mapping_handle);
+        if (file_handle != INVALID_HANDLE_VALUE) CloseHandle(file_handle);
+    }
+
+    #else
+
+    Mapped_File::Mapped_File(const std::string& path) : data(nullptr), size(0)
+    {
+        int descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0) return;
+
+        struct stat info;
+
+        if (fstat(descriptor, &info) == 0 && info.st_size > 0)
+        {
+            void* mapping = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+            if (mapping != MAP_FAILED)
+            {
+                data = static_cast<const uint8_t*>(mapping);
+                size = size_t(info.st_size);
+            }
+        }
+
+        // La proyección sigue siendo válida tras cerrar el descriptor
+        ::close(descriptor);
+    }
+
+    Mapped_File::~Mapped_File()
+    {
+        if (data) munmap(const_cast<uint8_t*>(data), size);
+    }
+
+    #endif
+
+    // ---- mesh_cache -----------------------------------------------------------------------------
+
+    namespace mesh_cache
+    {
+        namespace
+        {
+            const char MAGIC[4] = { 'U', 'M', 'S', 'H' };
+
+            // Tamaño y fecha de modificación con la mayor resolución disponible
+            bool get_source_info(const std::string& path, uint64_t& size, int64_t& mtime)
+            {
+                #ifdef _WIN32
+
+                WIN32_FILE_ATTRIBUTE_DATA info;
+                if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &info)) return false;
+
+                size  = (uint64_t(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+                mtime = int64_t((uint64_t(info.ftLastWriteTime.dwHighDateTime) << 32) | info.ftLastWriteTime.dwLowDateTime);
+
+                #else
+
+                struct stat info;
+                if (stat(path.c_str(), &info) != 0) return false;
+
+                size = uint64_t(info.st_size);
+
+                #if defined(__APPLE__)
+                mtime = int64_t(info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+                #else
+                mtime = int64_t(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+                #endif
+
+                #endif
+
+                return true;
+            }
+
+            // FNV-1a de 64 bits del contenido completo del archivo
+            bool hash_file(const std::string& path, uint64_t& hash)
+            {
+                std::ifstream file(path, std::ios::binary);
+                if (!file) return false;
+
+                hash = 14695981039346656037ull;
+
+                char buffer[64 * 1024];
+
+                while (file)
+                {
+                    file.read(buffer, sizeof(buffer));
+
+                    for (std::streamsize i = 0, n = file.gcount(); i < n; ++i)
+                    {
+                        hash ^= uint8_t(buffer[i]);
+                        hash *= 1099511628211ull;
+                    }
+                }
+
+                return true;
+            }
+
+            // Reescribe solo el campo source_mtime de la cabecera. Si falla, la caché sigue
+            // siendo válida y el hash se volverá a comprobar en la siguiente carga.
+            void update_source_mtime(const std::string& cache_path, int64_t mtime)
+            {
+                std::fstream file(cache_path, std::ios::binary | std::ios::in | std::ios::out);
+                if (!file) return;
+
+                file.seekp(std::streamoff(offsetof(Header, source_mtime)));
+                file.write(reinterpret_cast<const char*>(&mtime), sizeof(mtime));
+            }
+        }
+
+        std::string get_cache_path(const std::string& source_path)
+        {
+            return source_path + ".umesh";
+        }
+
+        bool open(const std::string& source_path, View& view)
+        {
+            UDIT_TRACE_SCOPE("mesh_cache::open");
+
+            uint64_t source_size;
+            int64_t  source_mtime;
+
+            if (!get_source_info(source_path, source_size, source_mtime)) return false;
+
+            std::unique_ptr<Mapped_File> file(new Mapped_File(get_cache_path(source_path)));
+
+            if (!file->is_open() || file->get_size() < sizeof(Header)) return false;
+
+            const Header* header = reinterpret_cast<const Header*>(file->get_data());
+
+            if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0
+                || header->version       != VERSION
+                || header->vertex_stride != sizeof(Geometry::Vertex)) return false;
+
+            size_t expected_size = sizeof(Header)
+                                 + size_t(header->submesh_count) * sizeof(Geometry::Submesh)
+                                 + size_t(header->lod_count    ) * sizeof(Geometry::Lod)
+                                 + size_t(header->vertex_count ) * sizeof(Geometry::Vertex)
+                                 + size_t(header->index_count  ) * sizeof(uint32_t);
+
+            if (file->get_size() != expected_size) return false;
+
+            // Fecha y tamaño iguales: válida. Si solo cambió la fecha (copia, checkout...)
+            // se compara el hash del contenido antes de descartarla.
+            if (header->source_size != source_size) return false;
+
+            if (header->source_mtime != source_mtime)
+            {
+                uint64_t source_hash;
+                if (!hash_file(source_path, source_hash) || source_hash != header->source_hash) return false;
+
+                // Mismo contenido con otra fecha: se guarda la nueva para no repetir el hash
+                // en cada arranque. En Windows la proyección impide escribir en el archivo,
+                // así que se cierra antes y se vuelve a proyectar.
+                file.reset();
+
+                update_source_mtime(get_cache_path(source_path), source_mtime);
+
+                file.reset(new Mapped_File(get_cache_path(source_path)));
+
+                if (!file->is_open() || file->get_size() != expected_size) return false;
+
+                header = reinterpret_cast<const Header*>(file->get_data());
+            }
+
+            const uint8_t* cursor = file->get_data() + sizeof(Header);
+
+            view.header    = header;
+            view.submeshes = reinterpret_cast<const Geometry::Submesh*>(cursor);
+            cursor        += header->submesh_count * sizeof(Geometry::Submesh);
+            view.lods      = reinterpret_cast<const Geometry::Lod*>(cursor);
+            cursor        += header->lod_count * sizeof(Geometry::Lod);
+            view.vertices  = reinterpret_cast<const Geometry::Vertex*>(cursor);
+            cursor        += header->vertex_count * sizeof(Geometry::Vertex);
+            view.indices   = reinterpret_cast<const uint32_t*>(cursor);
+            view.file      = std::move(file);
+
+            return true;
+        }
+
+        bool write
+        (
+            const std::string&                     source_path,
+            const std::vector<Geometry::Vertex>&   vertices,
+            const std::vector<uint32_t>&           indices,
+            const std::vector<Geometry::Submesh>&  submeshes,
+            const std::vector<Geometry::Lod>&      lods,
+            const Aabb&                            bounds,
+            const Sphere&                          sphere
+        )
+        {
+            UDIT_TRACE_SCOPE("mesh_cache::write");
+
+            Header header;
+            std::memset(&header, 0, sizeof(header));
+
+            std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+
+            header.version       = VERSION;
+            header.vertex_stride = sizeof(Geometry::Vertex);
+            header.submesh_count = uint32_t(submeshes.size());
+            header.lod_count     = uint32_t(lods     .size());
+            header.vertex_count  = uint32_t(vertices .size());
+            header.index_count   = uint32_t(indices  .size());
+
+            if (!get_source_info(source_path, header.source_size, header.source_mtime)) return false;
+            if (!hash_file      (source_path, header.source_hash)) return false;
+
+            for (int i = 0; i < 3; ++i)
+            {
+                header.bounds_min[i] = bounds.min[i];
+                header.bounds_max[i] = bounds.max[i];
+                header.sphere    [i] = sphere.center[i];
+            }
+
+            header.sphere[3] = sphere.radius;
+
+            // Se escribe en un temporal y se renombra para no dejar nunca una caché a medias
+            std::string cache_path = get_cache_path(source_path);
+            std::string temp_path  = cache_path + ".tmp";
+
+            {
+                std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+                if (!file) return false;
+
+                file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                file.write(reinterpret_cast<const char*>(submeshes.data()), submeshes.size() * sizeof(Geometry::Submesh));
+                file.write(reinterpret_cast<const char*>(lods     .data()), lods     .size() * sizeof(Geometry::Lod));
+                file.write(reinterpret_cast<const char*>(vertices .data()), vertices .size() * sizeof(Geometry::Vertex));
+                file.write(reinterpret_cast<const char*>(indices  .data()), indices  .size() * sizeof(uint32_t));
+
+                if (!file) return false;
+            }
+
+            std::remove(cache_path.c_str());
+
+            if (std::rename(temp_path.c_str(), cache_path.c_str()) != 0)
+            {
+                std::remove(temp_path.c_str());
+                return false;
+            }
+
+            return true;
+        }
+    }
+}
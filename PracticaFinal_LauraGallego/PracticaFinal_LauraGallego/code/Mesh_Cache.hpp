@@ -0,0 +1,102 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+#include "Geometry.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace udit
+{
+    // Archivo de solo lectura proyectado en memoria (mmap / MapViewOfFile)
+    class Mapped_File
+    {
+    private:
+
+        const uint8_t* data;
+        size_t         size;
+
+        #ifdef _WIN32
+        void*          file_handle;
+        void*          mapping_handle;
+        #endif
+
+    public:
+
+        explicit Mapped_File(const std::string& path);
+       ~Mapped_File();
+
+        Mapped_File(const Mapped_File&) = delete;
+        Mapped_File& operator=(const Mapped_File&) = delete;
+
+        bool           is_open () const { return data != nullptr; }
+        const uint8_t* get_data() const { return data; }
+        size_t         get_size() const { return size; }
+    };
+
+    // Caché binaria de modelos importados. Junto a cada modelo se guarda un archivo
+    // <ruta>.umesh con los vértices entrelazados en el formato de Geometry::Vertex,
+    // los índices (con los niveles de detalle detrás), las cajas y los rangos de submallas
+    // y de niveles, listo para subir a la GPU directamente desde la proyección en memoria.
+    //
+    // Disposición: Header | Submesh[submesh_count] | Lod[lod_count] | Vertex[vertex_count] | uint32[index_count]
+    namespace mesh_cache
+    {
+        const uint32_t VERSION = 3;            // 2: mallas optimizadas (Mesh_Optimizer), 3: niveles de detalle
+
+        struct Header
+        {
+            char     magic[4];                  // "UMSH"
+            uint32_t version;
+            uint32_t vertex_stride;             // sizeof(Geometry::Vertex) al escribirlo
+            uint32_t submesh_count;
+            uint32_t vertex_count;
+            uint32_t index_count;
+
+            // Identidad del archivo fuente para invalidar la caché
+            uint64_t source_size;
+            int64_t  source_mtime;               // Unidades propias de cada plataforma
+            uint64_t source_hash;               // FNV-1a del contenido
+
+            float    bounds_min[3];
+            float    bounds_max[3];
+            float    sphere[4];                 // centro y radio
+
+            uint32_t lod_count;
+            uint32_t reserved;
+        };
+
+        // Vista tipada sobre un archivo .umesh proyectado
+        struct View
+        {
+            std::unique_ptr<Mapped_File> file;
+
+            const Header*            header   = nullptr;
+            const Geometry::Submesh* submeshes = nullptr;
+            const Geometry::Lod*     lods     = nullptr;
+            const Geometry::Vertex*  vertices = nullptr;
+            const uint32_t*          indices  = nullptr;
+        };
+
+        std::string get_cache_path(const std::string& source_path);
+
+        // Proyecta la caché del modelo si existe y sigue correspondiendo a la fuente
+        bool open(const std::string& source_path, View& view);
+
+        // Escribe (o reemplaza) la caché del modelo; devuelve false si no se pudo
+        bool write
+        (
+            const std::string&                     source_path,
+            const std::vector<Geometry::Vertex>&   vertices,
+            const std::vector<uint32_t>&           indices,
+            const std::vector<Geometry::Submesh>&  submeshes,
+            const std::vector<Geometry::Lod>&      lods,
+            const Aabb&                            bounds,
+            const Sphere&                          sphere
+        );
+    }
+}
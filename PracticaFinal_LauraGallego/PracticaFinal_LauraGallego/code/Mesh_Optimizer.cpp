@@ -0,0 +1,433 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#include "Mesh_Optimizer.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+namespace udit
+{
+    namespace mesh_optimizer
+    {
+        namespace
+        {
+            // ---- Puntuación de Forsyth -------------------------------------------------------------
+
+            const float CACHE_DECAY_POWER   = 1.5f;
+            const float LAST_TRIANGLE_SCORE = 0.75f;
+            const float VALENCE_BOOST_SCALE = 2.0f;
+            const float VALENCE_BOOST_POWER = 0.5f;
+
+            float vertex_score(int cache_position, uint32_t remaining_triangles)
+            {
+                // Un vértice sin triángulos pendientes ya no aporta nada
+                if (remaining_triangles == 0) return -1.0f;
+
+                float score = 0.0f;
+
+                if (cache_position >= 0)
+                {
+                    // Los tres vértices del último triángulo puntúan fijo para no favorecer tiras
+                    if (cache_position < 3) score = LAST_TRIANGLE_SCORE;
+                    else
+                    {
+                        float scaler = 1.0f / float(CACHE_SIZE - 3);
+                        score = std::pow(1.0f - float(cache_position - 3) * scaler, CACHE_DECAY_POWER);
+                    }
+                }
+
+                // Prioridad a los vértices con pocos triángulos pendientes
+                score += VALENCE_BOOST_SCALE * std::pow(float(remaining_triangles), -VALENCE_BOOST_POWER);
+
+                return score;
+            }
+
+            // ---- Soldado ---------------------------------------------------------------------------
+
+            struct Vertex_Hash
+            {
+                size_t operator () (const Geometry::Vertex& vertex) const
+                {
+                    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vertex);
+
+                    uint64_t hash = 14695981039346656037ull;
+
+                    for (size_t i = 0; i < sizeof(Geometry::Vertex); ++i)
+                    {
+                        hash ^= bytes[i];
+                        hash *= 1099511628211ull;
+                    }
+
+                    return size_t(hash);
+                }
+            };
+
+            // Igualdad bit a bit: solo se sueldan vértices exactamente iguales
+            struct Vertex_Equal
+            {
+                bool operator () (const Geometry::Vertex& a, const Geometry::Vertex& b) const
+                {
+                    return std::memcmp(&a, &b, sizeof(Geometry::Vertex)) == 0;
+                }
+            };
+        }
+
+        Statistics analyze(const std::vector<uint32_t>& indices, size_t vertex_count, size_t cache_size)
+        {
+            Statistics statistics;
+
+            if (indices.empty() || vertex_count == 0) return statistics;
+
+            // Caché FIFO: la posición de entrada de cada vértice decide si sigue dentro
+            std::vector<size_t> timestamp(vertex_count, 0);
+            size_t              clock  = cache_size + 1;
+            size_t              misses = 0;
+
+            for (uint32_t index : indices)
+            {
+                if (clock - timestamp[index] > cache_size)
+                {
+                    timestamp[index] = clock++;
+                    misses++;
+                }
+            }
+
+            statistics.acmr = float(misses) / float(indices.size() / 3);
+            statistics.atvr = float(misses) / float(vertex_count);
+
+            return statistics;
+        }
+
+        size_t weld_vertices(std::vector<Geometry::Vertex>& vertices, std::vector<uint32_t>& indices)
+        {
+            std::unordered_map<Geometry::Vertex, uint32_t, Vertex_Hash, Vertex_Equal> unique;
+            unique.reserve(vertices.size());
+
+            std::vector<uint32_t>          remap(vertices.size());
+            std::vector<Geometry::Vertex>  welded;
+            welded.reserve(vertices.size());
+
+            for (size_t i = 0; i < vertices.size(); ++i)
+            {
+                auto inserted = unique.insert({ vertices[i], uint32_t(welded.size()) });
+
+                if (inserted.second) welded.push_back(vertices[i]);
+
+                remap[i] = inserted.first->second;
+            }
+
+            for (uint32_t& index : indices) index = remap[index];
+
+            vertices.swap(welded);
+
+            return vertices.size();
+        }
+
+        void optimize_vertex_cache(std::vector<uint32_t>& indices, size_t vertex_count)
+        {
+            size_t triangle_count = indices.size() / 3;
+
+            if (triangle_count == 0) return;
+
+            // Triángulos adyacentes a cada vértice (CSR); los ya emitidos se retiran de la lista
+            std::vector<uint32_t> remaining(vertex_count, 0);
+            std::vector<uint32_t> offsets  (vertex_count + 1, 0);
+
+            for (uint32_t index : indices) remaining[index]++;
+            for (size_t v = 0; v < vertex_count; ++v) offsets[v + 1] = offsets[v] + remaining[v];
+
+            std::vector<uint32_t> adjacency(indices.size());
+            {
+                std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+
+                for (size_t t = 0; t < triangle_count; ++t)
+                {
+                    for (int k = 0; k < 3; ++k) adjacency[cursor[indices[t * 3 + k]]++] = uint32_t(t);
+                }
+            }
+
+            std::vector<int>   cache_position(vertex_count, -1);
+            std::vector<float> vertex_scores (vertex_count);
+            std::vector<float> triangle_scores(triangle_count, 0.0f);
+            std::vector<bool>  emitted       (triangle_count, false);
+
+            for (size_t v = 0; v < vertex_count; ++v) vertex_scores[v] = vertex_score(-1, remaining[v]);
+
+            for (size_t t = 0; t < triangle_count; ++t)
+            {
+                for (int k = 0; k < 3; ++k) triangle_scores[t] += vertex_scores[indices[t * 3 + k]];
+            }
+
+            std::vector<uint32_t> cache, next_cache;
+            std::vector<uint32_t> output;
+
+            cache     .reserve(CACHE_SIZE + 3);
+            next_cache.reserve(CACHE_SIZE + 3);
+            output    .reserve(indices.size());
+
+            size_t best_triangle = size_t(std::max_element(triangle_scores.begin(), triangle_scores.end()) - triangle_scores.begin());
+            size_t scan_cursor   = 0;
+
+            for (size_t emitted_count = 0; emitted_count < triangle_count; ++emitted_count)
+            {
+                // Sin candidatos en la caché se continúa por el primer triángulo pendiente
+                if (best_triangle == size_t(-1))
+                {
+                    while (emitted[scan_cursor]) scan_cursor++;
+                    best_triangle = scan_cursor;
+                }
+
+                emitted[best_triangle] = true;
+
+                const uint32_t* triangle = &indices[best_triangle * 3];
+
+                // El triángulo sale de las listas de sus vértices
+                for (int k = 0; k < 3; ++k)
+                {
+                    uint32_t  v     = triangle[k];
+                    uint32_t* begin = &adjacency[offsets[v]];
+                    uint32_t* end   = begin + remaining[v];
+
+                    *std::find(begin, end, uint32_t(best_triangle)) = *(end - 1);
+                    remaining[v]--;
+
+                    output.push_back(v);
+                }
+
+                // Nueva caché: los tres vértices delante y el resto desplazado
+                next_cache.assign(triangle, triangle + 3);
+
+                for (uint32_t v : cache)
+                {
+                    if (v != triangle[0] && v != triangle[1] && v != triangle[2]) next_cache.push_back(v);
+                }
+
+                // Los que quedan fuera pierden su bonificación de caché
+                for (size_t i = CACHE_SIZE; i < next_cache.size(); ++i)
+                {
+                    uint32_t v = next_cache[i];
+                    cache_position[v] = -1;
+                    vertex_scores [v] = vertex_score(-1, remaining[v]);
+                }
+
+                if (next_cache.size() > CACHE_SIZE)
+                {
+                    // También hay que recalcular sus triángulos
+                    for (size_t i = CACHE_SIZE; i < next_cache.size(); ++i)
+                    {
+                        uint32_t v = next_cache[i];
+
+                        for (uint32_t a = offsets[v], e = offsets[v] + remaining[v]; a < e; ++a)
+                        {
+                            const uint32_t* other = &indices[adjacency[a] * 3];
+                            triangle_scores[adjacency[a]] = vertex_scores[other[0]] + vertex_scores[other[1]] + vertex_scores[other[2]];
+                        }
+                    }
+
+                    next_cache.resize(CACHE_SIZE);
+                }
+
+                cache.swap(next_cache);
+
+                for (size_t i = 0; i < cache.size(); ++i)
+                {
+                    uint32_t v = cache[i];
+                    cache_position[v] = int(i);
+                    vertex_scores [v] = vertex_score(int(i), remaining[v]);
+                }
+
+                // Siguiente triángulo: el mejor entre los que tocan la caché
+                best_triangle = size_t(-1);
+                float best_score = -1.0f;
+
+                for (uint32_t v : cache)
+                {
+                    for (uint32_t a = offsets[v], e = offsets[v] + remaining[v]; a < e; ++a)
+                    {
+                        uint32_t        t     = adjacency[a];
+                        const uint32_t* other = &indices[t * 3];
+                        float           score = vertex_scores[other[0]] + vertex_scores[other[1]] + vertex_scores[other[2]];
+
+                        triangle_scores[t] = score;
+
+                        if (score > best_score)
+                        {
+                            best_score    = score;
+                            best_triangle = t;
+                        }
+                    }
+                }
+            }
+
+            indices.swap(output);
+        }
+
+        void optimize_overdraw(std::vector<uint32_t>& indices, const std::vector<Geometry::Vertex>& vertices)
+        {
+            size_t triangle_count = indices.size() / 3;
+
+            if (triangle_count == 0) return;
+
+            // Grupos: se corta donde el orden de caché ya la vacía (triángulo con tres
+            // fallos), así reordenarlos apenas empeora el ACMR
+            std::vector<size_t> cluster_starts;
+            {
+                std::vector<size_t> timestamp(vertices.size(), 0);
+                size_t              clock = CACHE_SIZE + 1;
+
+                for (size_t t = 0; t < triangle_count; ++t)
+                {
+                    int misses = 0;
+
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        uint32_t v = indices[t * 3 + k];
+
+                        if (clock - timestamp[v] > CACHE_SIZE)
+                        {
+                            timestamp[v] = clock++;
+                            misses++;
+                        }
+                    }
+
+                    if (t == 0 || misses == 3) cluster_starts.push_back(t);
+                }
+            }
+
+            cluster_starts.push_back(triangle_count);
+
+            size_t cluster_count = cluster_starts.size() - 1;
+
+            // Centro de la malla ponderado por área
+            glm::vec3 mesh_center(0.0f);
+            float     mesh_area = 0.0f;
+
+            std::vector<glm::vec3> cluster_centers(cluster_count, glm::vec3(0.0f));
+            std::vector<glm::vec3> cluster_normals(cluster_count, glm::vec3(0.0f));
+            std::vector<float>     cluster_areas  (cluster_count, 0.0f);
+
+            for (size_t c = 0; c < cluster_count; ++c)
+            {
+                for (size_t t = cluster_starts[c]; t < cluster_starts[c + 1]; ++t)
+                {
+                    const glm::vec3& a = vertices[indices[t * 3 + 0]].Position;
+                    const glm::vec3& b = vertices[indices[t * 3 + 1]].Position;
+                    const glm::vec3& d = vertices[indices[t * 3 + 2]].Position;
+
+                    glm::vec3 normal = glm::cross(b - a, d - a);        // Longitud = 2 * área
+                    float     area   = glm::length(normal) * 0.5f;
+                    glm::vec3 center = (a + b + d) / 3.0f;
+
+                    cluster_centers[c] += center * area;
+                    cluster_normals[c] += normal;
+                    cluster_areas  [c] += area;
+
+                    mesh_center += center * area;
+                    mesh_area   += area;
+                }
+            }
+
+            if (mesh_area > 0.0f) mesh_center /= mesh_area;
+
+            // Los grupos más hacia fuera (en la dirección de su normal) se dibujan antes:
+            // ocluyen a los interiores desde casi cualquier punto de vista
+            std::vector<float>  cluster_keys(cluster_count);
+            std::vector<size_t> order       (cluster_count);
+
+            for (size_t c = 0; c < cluster_count; ++c)
+            {
+                glm::vec3 center = cluster_areas[c] > 0.0f ? cluster_centers[c] / cluster_areas[c] : mesh_center;
+                float     length = glm::length(cluster_normals[c]);
+                glm::vec3 normal = length > 0.0f ? cluster_normals[c] / length : glm::vec3(0.0f);
+
+                cluster_keys[c] = glm::dot(center - mesh_center, normal);
+                order       [c] = c;
+            }
+
+            std::stable_sort(order.begin(), order.end(), [&cluster_keys] (size_t a, size_t b) { return cluster_keys[a] > cluster_keys[b]; });
+
+            std::vector<uint32_t> output;
+            output.reserve(indices.size());
+
+            for (size_t c : order)
+            {
+                output.insert(output.end(), indices.begin() + cluster_starts[c] * 3, indices.begin() + cluster_starts[c + 1] * 3);
+            }
+
+            indices.swap(output);
+        }
+
+        void optimize_vertex_fetch(std::vector<Geometry::Vertex>& vertices, std::vector<uint32_t>& indices)
+        {
+            // Los vértices se renumeran por orden de primer uso; los no usados desaparecen
+            const uint32_t UNUSED = ~0u;
+
+            std::vector<uint32_t>         remap(vertices.size(), UNUSED);
+            std::vector<Geometry::Vertex> ordered;
+            ordered.reserve(vertices.size());
+
+            for (uint32_t& index : indices)
+            {
+                if (remap[index] == UNUSED)
+                {
+                    remap[index] = uint32_t(ordered.size());
+                    ordered.push_back(vertices[index]);
+                }
+
+                index = remap[index];
+            }
+
+            vertices.swap(ordered);
+        }
+
+        void optimize(std::vector<Geometry::Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<Geometry::Submesh>& submeshes)
+        {
+            UDIT_TRACE_SCOPE("mesh_optimizer::optimize");
+
+            Statistics before = analyze(indices, vertices.size());
+            size_t     vertex_count_before = vertices.size();
+
+            std::vector<Geometry::Vertex> all_vertices;
+            std::vector<uint32_t>         all_indices;
+
+            all_vertices.reserve(vertices.size());
+            all_indices .reserve(indices .size());
+
+            for (Geometry::Submesh& submesh : submeshes)
+            {
+                // Cada submalla se optimiza con sus propios vértices e índices locales
+                std::vector<Geometry::Vertex> local_vertices(vertices.begin() + submesh.base_vertex, vertices.begin() + submesh.base_vertex + submesh.vertex_count);
+                std::vector<uint32_t>         local_indices (indices .begin() + submesh.first_index, indices .begin() + submesh.first_index + submesh.index_count);
+
+                for (uint32_t& index : local_indices) index -= submesh.base_vertex;
+
+                weld_vertices        (local_vertices, local_indices);
+                optimize_vertex_cache(local_indices,  local_vertices.size());
+                optimize_overdraw    (local_indices,  local_vertices);
+                optimize_vertex_fetch(local_vertices, local_indices);
+
+                submesh.base_vertex  = uint32_t(all_vertices.size());
+                submesh.vertex_count = uint32_t(local_vertices.size());
+                submesh.first_index  = uint32_t(all_indices.size());
+                submesh.index_count  = uint32_t(local_indices.size());
+
+                for (uint32_t index : local_indices) all_indices.push_back(submesh.base_vertex + index);
+
+                all_vertices.insert(all_vertices.end(), local_vertices.begin(), local_vertices.end());
+            }
+
+            vertices.swap(all_vertices);
+            indices .swap(all_indices);
+
+            Statistics after = analyze(indices, vertices.size());
+
+            std::cout << "OPTIMIZACION: " << vertex_count_before << " -> " << vertices.size() << " vertices, "
+                      << "ACMR " << before.acmr << " -> " << after.acmr << ", "
+                      << "ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+        }
+    }
+}
@@ -0,0 +1,42 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+#include "Geometry.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace udit
+{
+    // Optimización de mallas tras la importación. Se ejecuta una sola vez por modelo
+    // (el resultado queda en la caché binaria) sobre cada submalla por separado:
+    //
+    //   1. Soldado de vértices idénticos.
+    //   2. Orden de triángulos para la caché de vértices transformados (Forsyth).
+    //   3. Orden de grupos de triángulos para reducir el overdraw (Sander et al.).
+    //   4. Orden de vértices por primer uso para la localidad de lectura.
+    namespace mesh_optimizer
+    {
+        // Tamaño de la caché FIFO simulada para ordenar y medir
+        const size_t CACHE_SIZE = 32;
+
+        struct Statistics
+        {
+            float acmr = 0.0f;      // Fallos de caché por triángulo (óptimo ~0.5, peor 3)
+            float atvr = 0.0f;      // Fallos de caché por vértice   (óptimo 1)
+        };
+
+        Statistics analyze(const std::vector<uint32_t>& indices, size_t vertex_count, size_t cache_size = CACHE_SIZE);
+
+        // Devuelve el número de vértices que quedan
+        size_t weld_vertices         (std::vector<Geometry::Vertex>& vertices, std::vector<uint32_t>& indices);
+        void   optimize_vertex_cache (std::vector<uint32_t>& indices, size_t vertex_count);
+        void   optimize_overdraw     (std::vector<uint32_t>& indices, const std::vector<Geometry::Vertex>& vertices);
+        void   optimize_vertex_fetch (std::vector<Geometry::Vertex>& vertices, std::vector<uint32_t>& indices);
+
+        // Todo lo anterior sobre cada submalla; actualiza los rangos de las submallas
+        void   optimize(std::vector<Geometry::Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<Geometry::Submesh>& submeshes);
+    }
+}
@@ -0,0 +1,446 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#include "Mesh_Simplifier.hpp"
+#include "Mesh_Optimizer.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+namespace udit
+{
+    namespace mesh_simplifier
+    {
+        namespace
+        {
+            // Un nivel que no quita al menos esta fracción de triángulos del anterior no compensa
+            const float MIN_REDUCTION = 0.9f;
+
+            const uint32_t NO_WEDGE = uint32_t(-1);
+
+            // Forma cuádrica simétrica: suma de distancias al cuadrado a un conjunto de planos,
+            // ponderados por el área de su triángulo
+            struct Quadric
+            {
+                double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+                double b0  = 0, b1  = 0, b2  = 0;
+                double c   = 0;
+                double weight = 0;
+
+                static Quadric from_plane(const glm::dvec3& n, double d, double w)
+                {
+                    Quadric q;
+                    q.a00 = w * n.x * n.x; q.a01 = w * n.x * n.y; q.a02 = w * n.x * n.z;
+                    q.a11 = w * n.y * n.y; q.a12 = w * n.y * n.z; q.a22 = w * n.z * n.z;
+                    q.b0  = w * n.x * d;   q.b1  = w * n.y * d;   q.b2  = w * n.z * d;
+                    q.c   = w * d * d;
+                    q.weight = w;
+                    return q;
+                }
+
+                Quadric& operator += (const Quadric& o)
+                {
+                    a00 += o.a00; a01 += o.a01; a02 += o.a02; a11 += o.a11; a12 += o.a12; a22 += o.a22;
+                    b0  += o.b0;  b1  += o.b1;  b2  += o.b2;
+                    c   += o.c;
+                    weight += o.weight;
+                    return *this;
+                }
+
+                // Distancia media al cuadrado de p a los planos acumulados
+                double error(const glm::vec3& p) const
+                {
+                    double x = p.x, y = p.y, z = p.z;
+
+                    double value = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z
+                                 + a11 * y * y + 2 * a12 * y * z + a22 * z * z
+                                 + 2 * (b0 * x + b1 * y + b2 * z) + c;
+
+                    return weight > 0 ? std::fabs(value) / weight : 0.0;
+                }
+            };
+
+            struct Collapse
+            {
+                uint32_t from;
+                uint32_t to;
+                float    cost;
+            };
+
+            struct Position_Hash
+            {
+                size_t operator () (const glm::vec3& p) const
+                {
+                    // -0.0 y 0.0 son iguales para operator == y tienen que dar el mismo hash
+                    float    canonical[3] = { p.x == 0.0f ? 0.0f : p.x, p.y == 0.0f ? 0.0f : p.y, p.z == 0.0f ? 0.0f : p.z };
+                    uint32_t bits[3];
+
+                    std::memcpy(bits, canonical, sizeof(bits));
+
+                    return size_t(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+                }
+            };
+
+            // Estado que se conserva entre niveles: cada nivel parte del anterior y las
+            // cuádricas siguen midiendo la distancia a la superficie original.
+            //
+            // Los vértices con la misma posición y distintos atributos (las cuñas de una
+            // costura) comparten cuádrica y bloqueo, y se colapsan todos a la vez.
+            class Simplifier
+            {
+            private:
+
+                const std::vector<Geometry::Vertex>& vertices;
+
+                std::vector<uint32_t> indices;
+                std::vector<uint32_t> position_id;          // Por vértice
+                std::vector<uint32_t> wedge_offsets;        // Por posición, rango de sus cuñas en wedges
+                std::vector<uint32_t> wedges;
+                std::vector<Quadric>  quadrics;             // Por posición
+                std::vector<bool>     locked;               // Por posición
+
+                float error;
+
+            public:
+
+                Simplifier(const std::vector<Geometry::Vertex>& vertices, const std::vector<uint32_t>& source)
+                :
+                    vertices(vertices),
+                    indices (source),
+                    error   (0.0f)
+                {
+                    group_wedges();
+                    compute_quadrics();
+                    lock_borders();
+                }
+
+                const std::vector<uint32_t>& get_indices() const { return indices; }
+                float                        get_error  () const { return error;   }
+
+                void simplify(size_t target_index_count);
+
+            private:
+
+                const glm::vec3& position(uint32_t v) const { return vertices[v].Position; }
+
+                void group_wedges();
+                void compute_quadrics();
+                void lock_borders();
+                bool gather_moves(const Collapse& collapse, const std::vector<uint32_t>& offsets, const std::vector<uint32_t>& adjacency, std::vector<Collapse>& moves) const;
+                bool flips(uint32_t from, uint32_t to, const std::vector<uint32_t>& offsets, const std::vector<uint32_t>& adjacency) const;
+            };
+
+            void Simplifier::group_wedges()
+            {
+                // Identificador por posición: vértices con la misma posición son la misma
+                // esquina de la superficie aunque difieran en normal o UV
+                std::unordered_map<glm::vec3, uint32_t, Position_Hash> unique;
+
+                position_id.resize(vertices.size());
+                wedge_offsets.assign(1, 0);
+
+                for (size_t v = 0; v < vertices.size(); ++v)
+                {
+                    auto inserted = unique.insert({ position(uint32_t(v)), uint32_t(wedge_offsets.size() - 1) });
+
+                    if (inserted.second) wedge_offsets.push_back(0);
+
+                    position_id[v] = inserted.first->second;
+                    wedge_offsets[position_id[v] + 1]++;
+                }
+
+                for (size_t p = 1; p < wedge_offsets.size(); ++p) wedge_offsets[p] += wedge_offsets[p - 1];
+
+                wedges.resize(vertices.size());
+
+                std::vector<uint32_t> cursor(wedge_offsets.begin(), wedge_offsets.end() - 1);
+
+                for (size_t v = 0; v < vertices.size(); ++v) wedges[cursor[position_id[v]]++] = uint32_t(v);
+
+                quadrics.assign(wedge_offsets.size() - 1, Quadric());
+                locked  .assign(wedge_offsets.size() - 1, false);
+            }
+
+            void Simplifier::compute_quadrics()
+            {
+                for (size_t t = 0; t + 2 < indices.size(); t += 3)
+                {
+                    glm::dvec3 a(position(indices[t + 0]));
+                    glm::dvec3 b(position(indices[t + 1]));
+                    glm::dvec3 c(position(indices[t + 2]));
+
+                    glm::dvec3 normal = glm::cross(b - a, c - a);
+                    double     length = glm::length(normal);
+
+                    if (length <= 0.0) continue;
+
+                    normal /= length;
+
+                    Quadric plane = Quadric::from_plane(normal, -glm::dot(normal, a), length * 0.5);
+
+                    for (int k = 0; k < 3; ++k) quadrics[position_id[indices[t + k]]] += plane;
+                }
+            }
+
+            void Simplifier::lock_borders()
+            {
+                // Bordes: aristas (por posición) con un único triángulo; las de costura
+                // tienen triángulo a ambos lados y no cuentan
+                std::unordered_map<uint64_t, uint32_t> edge_uses;
+                edge_uses.reserve(indices.size());
+
+                auto edge_key = [this] (uint32_t a, uint32_t b)
+                {
+                    uint64_t pa = position_id[a], pb = position_id[b];
+                    return pa < pb ? (pa << 32 | pb) : (pb << 32 | pa);
+                };
+
+                for (size_t t = 0; t + 2 < indices.size(); t += 3)
+                {
+                    for (int k = 0; k < 3; ++k) edge_uses[edge_key(indices[t + k], indices[t + (k + 1) % 3])]++;
+                }
+
+                for (size_t t = 0; t + 2 < indices.size(); t += 3)
+                {
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        uint32_t a = indices[t + k], b = indices[t + (k + 1) % 3];
+
+                        if (edge_uses[edge_key(a, b)] == 1) locked[position_id[a]] = locked[position_id[b]] = true;
+                    }
+                }
+            }
+
+            bool Simplifier::gather_moves(const Collapse& collapse, const std::vector<uint32_t>& offsets, const std::vector<uint32_t>& adjacency, std::vector<Collapse>& moves) const
+            {
+                // Cada cuña de la posición de origen que siga en uso se colapsa sobre la cuña
+                // del destino con la que comparte triángulo. Si alguna no tiene ninguna (una
+                // costura que no sigue la arista) o tiene varias (el colapso cruzaría la
+                // costura) no se puede mover la posición sin estropear los atributos
+                uint32_t source = position_id[collapse.from];
+                uint32_t target = position_id[collapse.to  ];
+
+                moves.clear();
+
+                for (uint32_t w = wedge_offsets[source]; w < wedge_offsets[source + 1]; ++w)
+                {
+                    uint32_t from = wedges[w];
+                    uint32_t to   = NO_WEDGE;
+
+                    if (offsets[from] == offsets[from + 1]) continue;
+
+                    for (uint32_t a = offsets[from]; a < offsets[from + 1]; ++a)
+                    {
+                        const uint32_t* triangle = &indices[adjacency[a] * 3];
+
+                        for (int k = 0; k < 3; ++k)
+                        {
+                            if (position_id[triangle[k]] != target || triangle[k] == to) continue;
+
+                            if (to != NO_WEDGE) return false;
+
+                            to = triangle[k];
+                        }
+                    }
+
+                    if (to == NO_WEDGE) return false;
+
+                    moves.push_back({ from, to, collapse.cost });
+                }
+
+                return true;
+            }
+
+            bool Simplifier::flips(uint32_t from, uint32_t to, const std::vector<uint32_t>& offsets, const std::vector<uint32_t>& adjacency) const
+            {
+                // Ningún triángulo que sobreviva al colapso puede darse la vuelta
+                for (uint32_t a = offsets[from]; a < offsets[from + 1]; ++a)
+                {
+                    const uint32_t* triangle = &indices[adjacency[a] * 3];
+
+                    if (triangle[0] == to || triangle[1] == to || triangle[2] == to) continue;
+
+                    glm::vec3 p[3], q[3];
+
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        p[k] = position(triangle[k]);
+                        q[k] = triangle[k] == from ? position(to) : p[k];
+                    }
+
+                    glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                    glm::vec3 after  = glm::cross(q[1] - q[0], q[2] - q[0]);
+
+                    if (glm::dot(before, after) <= 0.0f) return true;
+                }
+
+                return false;
+            }
+
+            void Simplifier::simplify(size_t target_index_count)
+            {
+                std::vector<Collapse> collapses, moves;
+                std::vector<uint32_t> offsets, adjacency, remap;
+                std::vector<bool>     touched;
+
+                // Cada pasada colapsa, de menor a mayor coste, un conjunto de aristas que no
+                // comparten triángulos; así la adyacencia sigue siendo válida durante la pasada
+                while (indices.size() > target_index_count)
+                {
+                    size_t vertex_count   = vertices.size();
+                    size_t triangle_count = indices.size() / 3;
+
+                    offsets.assign(vertex_count + 1, 0);
+                    for (uint32_t index : indices) offsets[index + 1]++;
+                    for (size_t v = 0; v < vertex_count; ++v) offsets[v + 1] += offsets[v];
+
+                    adjacency.resize(indices.size());
+                    {
+                        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+
+                        for (size_t t = 0; t < triangle_count; ++t)
+                        {
+                            for (int k = 0; k < 3; ++k) adjacency[cursor[indices[t * 3 + k]]++] = uint32_t(t);
+                        }
+                    }
+
+                    collapses.clear();
+
+                    for (size_t t = 0; t < triangle_count; ++t)
+                    {
+                        for (int k = 0; k < 3; ++k)
+                        {
+                            uint32_t a  = indices[t * 3 + k], b = indices[t * 3 + (k + 1) % 3];
+                            uint32_t pa = position_id[a],     pb = position_id[b];
+
+                            if (pa == pb) continue;
+
+                            Quadric q = quadrics[pa];
+                            q += quadrics[pb];
+
+                            if (!locked[pa]) collapses.push_back({ a, b, float(q.error(position(b))) });
+                            if (!locked[pb]) collapses.push_back({ b, a, float(q.error(position(a))) });
+                        }
+                    }
+
+                    if (collapses.empty()) break;
+
+                    std::sort(collapses.begin(), collapses.end(), [] (const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+                    touched.assign(vertex_count, false);
+                    remap  .resize(vertex_count);
+
+                    for (size_t v = 0; v < vertex_count; ++v) remap[v] = uint32_t(v);
+
+                    size_t triangles_to_remove = (indices.size() - target_index_count + 2) / 3;
+                    size_t removed = 0;
+
+                    for (const Collapse& collapse : collapses)
+                    {
+                        if (removed >= triangles_to_remove) break;
+
+                        if (!gather_moves(collapse, offsets, adjacency, moves)) continue;
+
+                        bool valid = true;
+
+                        for (const Collapse& move : moves)
+                        {
+                            if (touched[move.from] || touched[move.to] || flips(move.from, move.to, offsets, adjacency)) valid = false;
+                        }
+
+                        if (!valid) continue;
+
+                        quadrics[position_id[collapse.to]] += quadrics[position_id[collapse.from]];
+
+                        for (const Collapse& move : moves)
+                        {
+                            remap[move.from] = move.to;
+
+                            // Se bloquea el vecindario de ambos extremos hasta la siguiente pasada
+                            for (uint32_t end : { move.from, move.to })
+                            {
+                                for (uint32_t a = offsets[end]; a < offsets[end + 1]; ++a)
+                                {
+                                    const uint32_t* triangle = &indices[adjacency[a] * 3];
+
+                                    touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+
+                                    if (end == move.from && (triangle[0] == move.to || triangle[1] == move.to || triangle[2] == move.to)) removed++;
+                                }
+                            }
+                        }
+
+                        error = std::max(error, std::sqrt(collapse.cost));
+                    }
+
+                    if (removed == 0) break;
+
+                    // Reescritura de índices sin los triángulos degenerados
+                    size_t write = 0;
+
+                    for (size_t t = 0; t < triangle_count; ++t)
+                    {
+                        uint32_t a = remap[indices[t * 3 + 0]];
+                        uint32_t b = remap[indices[t * 3 + 1]];
+                        uint32_t c = remap[indices[t * 3 + 2]];
+
+                        if (a == b || b == c || a == c) continue;
+
+                        indices[write++] = a;
+                        indices[write++] = b;
+                        indices[write++] = c;
+                    }
+
+                    indices.resize(write);
+                }
+            }
+        }
+
+        void build_lods(const std::vector<Geometry::Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<Geometry::Lod>& lods)
+        {
+            UDIT_TRACE_SCOPE("mesh_simplifier::build_lods");
+
+            size_t source_count = indices.size();
+
+            lods.clear();
+            lods.push_back({ 0, uint32_t(source_count), 0.0f });
+
+            if (source_count == 0) return;
+
+            Simplifier simplifier(vertices, indices);
+
+            for (float ratio : LOD_RATIOS)
+            {
+                size_t target = size_t(float(source_count / 3) * ratio) * 3;
+                size_t last   = lods.back().index_count;
+
+                simplifier.simplify(target);
+
+                std::vector<uint32_t> lod_indices = simplifier.get_indices();
+
+                if (float(lod_indices.size()) > float(last) * MIN_REDUCTION) break;
+
+                mesh_optimizer::optimize_vertex_cache(lod_indices, vertices.size());
+
+                lods.push_back({ uint32_t(indices.size()), uint32_t(lod_indices.size()), simplifier.get_error() });
+                indices.insert(indices.end(), lod_indices.begin(), lod_indices.end());
+            }
+
+            std::cout << "LOD: " << lods.size() << " niveles:";
+
+            for (const Geometry::Lod& lod : lods)
+            {
+                std::cout << " " << lod.index_count / 3 << " (" << lod.error << ")";
+            }
+
+            // Sin niveles reducidos la malla se dibuja siempre completa; suele deberse a
+            // bordes o costuras que no se pueden colapsar (por ejemplo normales por cara)
+            if (lods.size() == 1) std::cout << " - sin niveles reducidos: bordes o costuras bloqueados";
+
+            std::cout << std::endl;
+        }
+    }
+}
@@ -0,0 +1,29 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+#include "Geometry.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace udit
+{
+    // Simplificación por colapso de aristas con métrica de error cuádrica (Garland y
+    // Heckbert). Cada vértice se colapsa sobre uno de sus vecinos, de modo que todos los
+    // niveles de detalle comparten el mismo buffer de vértices y solo cambian los índices.
+    // Los vértices de borde no se mueven; los de costura (misma posición con otros
+    // atributos) solo se colapsan a lo largo de la costura y todos a la vez.
+    namespace mesh_simplifier
+    {
+        // Fracción de triángulos de cada nivel respecto al original
+        const float LOD_RATIOS[] = { 0.5f, 0.25f, 0.1f };
+
+        // Añade tras los índices originales los de cada nivel que se pueda generar y
+        // rellena lods con todos los rangos (el nivel 0 es la malla completa). El error
+        // de cada nivel es la distancia aproximada a la superficie original en unidades
+        // del modelo.
+        void build_lods(const std::vector<Geometry::Vertex>& vertices, std::vector<uint32_t>& indices, std::vector<Geometry::Lod>& lods);
+    }
+}
@@ -1,18 +1,17 @@
-// Este cdigo es de dominio pblico
+// Este código es de dominio público
 // penterrin@gmail.com
 
 #include "Node.hpp"
 #include "Camera.hpp" 
+#include "Frustum.hpp"
+#include "Trace.hpp"
 
 namespace udit
 {
     Node::Node()
         : parent(nullptr),
-        position(0.0f),
-        rotation(0.0f),
-        scale(1.0f),
-        local_matrix(1.0f),
-        global_matrix(1.0f)
+        transform(Transform_Store::instance().create()),
+        subtree_culled(false)
     {
     }
 
@@ -22,12 +21,17 @@ namespace udit
             delete child;
         }
         children.clear();
+
+        Transform_Store::instance().destroy(transform);
     }
 
     void Node::add_child(Node* child)
     {
         child->parent = this;
         children.push_back(child);
+
+        // El hijo debe recalcular su matriz global respecto al nuevo padre
+        Transform_Store::instance().set_parent(child->transform, transform);
     }
 
     void Node::remove_child(Node* child)
@@ -37,27 +41,31 @@ namespace udit
 
     void Node::update()
     {
-        // Construccin de la matriz local TRS (Translate, Rotate, Scale)
-        local_matrix = glm::mat4(1.0f);
-        local_matrix = glm::translate(local_matrix, position);
+        UDIT_TRACE_SCOPE("Node::update");
+
+        Transform_Store::instance().update();
+    }
 
-        local_matrix = glm::rotate(local_matrix, glm::radians(rotation.x), glm::vec3(1, 0, 0));
-        local_matrix = glm::rotate(local_matrix, glm::radians(rotation.y), glm::vec3(0, 1, 0));
-        local_matrix = glm::rotate(local_matrix, glm::radians(rotation.z), glm::vec3(0, 0, 1));
+    const Aabb& Node::update_bounds()
+    {
+        Aabb local;
 
-        local_matrix = glm::scale(local_matrix, scale);
+        subtree_bounds = get_local_bounds(local) ? local.transformed(get_global_matrix()) : Aabb();
 
-        // Multiplicacin por matriz del padre si existe jerarqua
-        if (parent) {
-            global_matrix = parent->global_matrix * local_matrix;
-        }
-        else {
-            global_matrix = local_matrix;
+        for (auto child : children) {
+            subtree_bounds.extend(child->update_bounds());
         }
 
-        // Propagacin de actualizacin a los nodos hijos
+        return subtree_bounds;
+    }
+
+    void Node::cull_hierarchy(const Frustum& frustum, bool parent_culled)
+    {
+        subtree_culled = parent_culled || !frustum.intersects(subtree_bounds);
+
+        // Las hojas se prueban por lotes fuera de aquí
         for (auto child : children) {
-            child->update();
+            if (!child->children.empty()) child->cull_hierarchy(frustum, subtree_culled);
         }
     }
 
@@ -1,4 +1,4 @@
-// Este cdigo es de dominio pblico
+// Este código es de dominio público
 // penterrin@gmail.com
 
 #pragma once
@@ -7,11 +7,17 @@
 #include <vector>
 #include <glm.hpp>
 #include <gtc/matrix_transform.hpp>
+#include "Transform_Store.hpp"
+#include "Bounds.hpp"
 
 
 namespace udit
 {
     class Camera;
+    class Frustum;
+
+    // Nodo del grafo de escena. Las transformaciones viven en Transform_Store;
+    // el nodo solo guarda su handle y la jerarquía para el renderizado.
     class Node
     {
     protected:
@@ -19,39 +25,52 @@ namespace udit
         Node* parent;
         std::vector<Node*> children;
 
-       
-        glm::vec3 position;
-        glm::vec3 rotation; 
-        glm::vec3 scale;
+        Transform_Store::Handle transform;
 
-       
-        glm::mat4 local_matrix;
-        glm::mat4 global_matrix;
+        Aabb subtree_bounds;            // Caja en mundo del nodo y todos sus descendientes
+        bool subtree_culled;            // Resultado de la última prueba jerárquica
 
     public:
         Node();
         virtual ~Node();
 
+        Node(const Node&) = delete;
+        Node& operator=(const Node&) = delete;
        
         void add_child(Node* child);
         void remove_child(Node* child);
 
-       
+        // Propaga las matrices de todo el almacén de transformaciones (llamar sobre la raíz)
         virtual void update();
         virtual void render(const Camera& camera);
 
+        Node* get_parent() const { return parent; }
+        const std::vector<Node*>& get_children() const { return children; }
+
+        // Caja local del contenido propio del nodo; false si no tiene geometría
+        virtual bool get_local_bounds(Aabb& /*bounds*/) const { return false; }
+
+        // Recalcula recursivamente las cajas en mundo de los subárboles (tras update)
+        const Aabb& update_bounds();
+        const Aabb& get_subtree_bounds() const { return subtree_bounds; }
+
+        // Prueba las cajas de los nodos interiores contra la pirámide; un subárbol
+        // descartado descarta a todos sus descendientes sin probarlos uno a uno
+        void cull_hierarchy(const Frustum& frustum, bool parent_culled = false);
+        bool is_subtree_culled() const { return subtree_culled; }
+
         
-        void set_position(const glm::vec3& pos) { position = pos; }
-        void set_rotation(const glm::vec3& rot) { rotation = rot; }
-        void set_scale(const glm::vec3& scl) { scale = scl; }
+        void set_position(const glm::vec3& pos) { Transform_Store::instance().set_position(transform, pos); }
+        void set_rotation(const glm::vec3& rot) { Transform_Store::instance().set_rotation(transform, rot); }
+        void set_scale(const glm::vec3& scl) { Transform_Store::instance().set_scale(transform, scl); }
 
        
-        glm::vec3 get_position() const { return position; }
-        glm::vec3 get_rotation() const { return rotation; }       
-        glm::vec3 get_scale()    const { return scale; }
-        const glm::mat4& get_global_matrix() const { return global_matrix; }
+        glm::vec3 get_position() const { return Transform_Store::instance().get_position(transform); }
+        glm::vec3 get_rotation() const { return Transform_Store::instance().get_rotation(transform); }
+        glm::vec3 get_scale()    const { return Transform_Store::instance().get_scale(transform); }
+        const glm::mat4& get_global_matrix() const { return Transform_Store::instance().get_world_matrix(transform); }
 
-    private:
-        void update_matrices();
+        // Permite a los renderers saltarse la subida de matrices que no han cambiado
+        unsigned get_world_version() const { return Transform_Store::instance().get_world_version(transform); }
     };
-}
\ No newline at end of file
+}
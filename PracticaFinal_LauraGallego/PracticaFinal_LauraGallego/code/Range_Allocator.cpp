@@ -0,0 +1,119 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#include "Range_Allocator.hpp"
+#include <algorithm>
+
+namespace udit
+{
+    const size_t Range_Allocator::INVALID;
+
+    Range_Allocator::Range_Allocator(size_t capacity) : capacity(0), used(0), allocations(0)
+    {
+        grow(capacity);
+    }
+
+    size_t Range_Allocator::allocate(size_t size)
+    {
+        if (size == 0) return INVALID;
+
+        // El hueco más pequeño en el que cabe
+        auto fit = free_by_size.lower_bound(size);
+
+        if (fit == free_by_size.end()) return INVALID;
+
+        size_t offset = fit->second;
+        size_t block  = fit->first;
+
+        erase_free(free_by_offset.find(offset));
+
+        if (block > size) insert_free(offset + size, block - size);
+
+        used += size;
+        allocations++;
+
+        return offset;
+    }
+
+    void Range_Allocator::free(size_t offset, size_t size)
+    {
+        if (size == 0 || offset == INVALID) return;
+
+        used -= size;
+        allocations--;
+
+        // Fusión con los huecos contiguos por ambos lados
+        auto next = free_by_offset.lower_bound(offset);
+
+        if (next != free_by_offset.end() && next->first == offset + size)
+        {
+            size += next->second;
+            next  = std::next(next);
+            erase_free(std::prev(next));
+        }
+
+        if (next != free_by_offset.begin())
+        {
+            auto previous = std::prev(next);
+
+            if (previous->first + previous->second == offset)
+            {
+                offset  = previous->first;
+                size   += previous->second;
+                erase_free(previous);
+            }
+        }
+
+        insert_free(offset, size);
+    }
+
+    void Range_Allocator::grow(size_t new_capacity)
+    {
+        if (new_capacity <= capacity) return;
+
+        size_t old_capacity = capacity;
+
+        // El nuevo tramo se libera como si fuera una asignación devuelta, así se fusiona
+        // con el hueco final si lo hay
+        capacity = new_capacity;
+        used    += new_capacity - old_capacity;
+        allocations++;
+
+        free(old_capacity, new_capacity - old_capacity);
+    }
+
+    Range_Allocator::Statistics Range_Allocator::get_statistics() const
+    {
+        Statistics statistics;
+
+        statistics.capacity           = capacity;
+        statistics.used               = used;
+        statistics.allocations        = allocations;
+        statistics.free_blocks        = free_by_offset.size();
+        statistics.largest_free_block = free_by_size.empty() ? 0 : free_by_size.rbegin()->first;
+
+        return statistics;
+    }
+
+    void Range_Allocator::insert_free(size_t offset, size_t size)
+    {
+        free_by_offset.insert({ offset, size });
+        free_by_size  .insert({ size, offset });
+    }
+
+    void Range_Allocator::erase_free(std::map<size_t, size_t>::iterator block)
+    {
+        auto range = free_by_size.equal_range(block->second);
+
+        for (auto i = range.first; i != range.second; ++i)
+        {
+            if (i->second == block->first)
+            {
+                free_by_size.erase(i);
+                break;
+            }
+        }
+
+        free_by_offset.erase(block);
+    }
+}
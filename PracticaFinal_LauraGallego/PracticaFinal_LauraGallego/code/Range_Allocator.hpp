@@ -0,0 +1,66 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+
+namespace udit
+{
+    // Reparto de rangos [offset, offset + size) dentro de un espacio lineal (en las
+    // unidades que use quien lo posee: vértices, índices...). Los huecos libres se
+    // indexan por posición, para fusionar vecinos al liberar, y por tamaño, para elegir
+    // el más ajustado en O(log n).
+    class Range_Allocator
+    {
+    public:
+
+        static const size_t INVALID = size_t(-1);
+
+        struct Statistics
+        {
+            size_t capacity           = 0;
+            size_t used               = 0;
+            size_t allocations        = 0;
+            size_t free_blocks        = 0;
+            size_t largest_free_block = 0;
+
+            // 0 si todo el espacio libre es contiguo; tiende a 1 cuanto más repartido está
+            float  fragmentation() const
+            {
+                size_t free = capacity - used;
+                return free > 0 ? 1.0f - float(largest_free_block) / float(free) : 0.0f;
+            }
+        };
+
+    private:
+
+        std::map<size_t, size_t>      free_by_offset;       // offset -> tamaño
+        std::multimap<size_t, size_t> free_by_size;         // tamaño -> offset
+
+        size_t capacity;
+        size_t used;
+        size_t allocations;
+
+    public:
+
+        explicit Range_Allocator(size_t capacity = 0);
+
+        // Devuelve el offset del rango o INVALID si no hay un hueco suficiente
+        size_t allocate(size_t size);
+        void   free    (size_t offset, size_t size);
+
+        // Amplía el espacio por el final (el contenido existente no se mueve)
+        void   grow    (size_t new_capacity);
+
+        size_t get_capacity() const { return capacity; }
+
+        Statistics get_statistics() const;
+
+    private:
+
+        void insert_free(size_t offset, size_t size);
+        void erase_free (std::map<size_t, size_t>::iterator block);
+    };
+}
@@ -0,0 +1,155 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#include "Render_Queue.hpp"
+#include "Frame_Uniforms.hpp"
+#include "Mesh.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+
+namespace udit
+{
+    namespace
+    {
+        // Anchura de cada campo de la clave; los identificadores de OpenGL se recortan a
+        // ella, lo que en el peor caso junta estados distintos pero nunca rompe el orden
+        const int PASS_BITS    = 2;
+        const int PROGRAM_BITS = 10;
+        const int TEXTURE_BITS = 14;
+        const int VAO_BITS     = 10;
+        const int DEPTH_BITS   = 24;
+
+        const int PASS_SHIFT   = 64 - PASS_BITS;
+
+        uint64_t field(uint64_t value, int bits, int shift)
+        {
+            return (value & ((uint64_t(1) << bits) - 1)) << shift;
+        }
+
+        Render_Queue::Pass get_pass(uint64_t key)
+        {
+            return Render_Queue::Pass(key >> PASS_SHIFT);
+        }
+    }
+
+    void Render_Queue::begin(float far_distance)
+    {
+        this->far_distance = far_distance > 0.0f ? far_distance : 1.0f;
+
+        items.clear();
+        statistics = Statistics();
+    }
+
+    void Render_Queue::add(const Mesh& mesh, Pass pass, float distance)
+    {
+        const Geometry* geometry = mesh.get_geometry();
+
+        if (!geometry) return;
+
+        GLuint texture = mesh.get_texture() ? mesh.get_texture()->get_id() : 0;
+
+        items.push_back({ make_key(pass, mesh.get_program()->get_id(), texture, geometry->get_vao(), distance), &mesh });
+    }
+
+    uint64_t Render_Queue::make_key(Pass pass, GLuint program, GLuint texture, GLuint vao, float distance) const
+    {
+        const uint64_t DEPTH_MAX = (uint64_t(1) << DEPTH_BITS) - 1;
+
+        uint64_t depth = uint64_t(std::min(std::max(distance / far_distance, 0.0f), 1.0f) * float(DEPTH_MAX));
+
+        uint64_t key = field(pass, PASS_BITS, PASS_SHIFT);
+
+        if (pass == OPAQUE)
+        {
+            int shift = PASS_SHIFT;
+
+            key |= field(program, PROGRAM_BITS, shift -= PROGRAM_BITS);
+            key |= field(texture, TEXTURE_BITS, shift -= TEXTURE_BITS);
+            key |= field(vao,     VAO_BITS,     shift -= VAO_BITS    );
+            key |= field(depth,   DEPTH_BITS,   shift -= DEPTH_BITS  );
+        }
+        else
+        {
+            int shift = PASS_SHIFT;
+
+            key |= field(DEPTH_MAX - depth, DEPTH_BITS,   shift -= DEPTH_BITS  );
+            key |= field(program,           PROGRAM_BITS, shift -= PROGRAM_BITS);
+            key |= field(texture,           TEXTURE_BITS, shift -= TEXTURE_BITS);
+            key |= field(vao,               VAO_BITS,     shift -= VAO_BITS    );
+        }
+
+        return key;
+    }
+
+    void Render_Queue::sort()
+    {
+        UDIT_TRACE_SCOPE("Render_Queue::sort");
+
+        if (items.size() < 2) return;
+
+        scratch.resize(items.size());
+
+        // Radix LSD de ocho bits por pasada; se saltan los bytes iguales en todas las claves
+        for (int shift = 0; shift < 64; shift += 8)
+        {
+            size_t counts[256] = {};
+
+            for (const Item& item : items) counts[(item.key >> shift) & 0xFF]++;
+
+            if (counts[(items.front().key >> shift) & 0xFF] == items.size()) continue;
+
+            size_t offset = 0;
+
+            for (size_t& count : counts)
+            {
+                size_t bucket = count;
+                count   = offset;
+                offset += bucket;
+            }
+
+            for (const Item& item : items) scratch[counts[(item.key >> shift) & 0xFF]++] = item;
+
+            items.swap(scratch);
+        }
+    }
+
+    void Render_Queue::submit(Pass pass, bool depth_only)
+    {
+        UDIT_TRACE_SCOPE("Render_Queue::submit");
+
+        // El pre-pase no lleva contadores propios: las estadísticas son las del pase con color
+        Statistics ignored;
+        Statistics& counters = depth_only ? ignored : statistics;
+
+        auto first = std::find_if(items.begin(), items.end(), [pass] (const Item& item) { return get_pass(item.key) == pass; });
+
+        GLuint bound_program = 0;
+        GLuint bound_texture = 0;
+        GLuint bound_vao     = 0;
+
+        glActiveTexture(GL_TEXTURE0);
+
+        for (auto item = first; item != items.end() && get_pass(item->key) == pass; ++item)
+        {
+            const Mesh&     mesh     = *item->mesh;
+            const Geometry& geometry = *mesh.get_geometry();
+
+            GLuint program = depth_only ? mesh.get_depth_program()->get_id() : mesh.get_program()->get_id();
+            GLuint texture = mesh.get_texture() && !depth_only ? mesh.get_texture()->get_id() : 0;
+            GLuint vao     = geometry.get_vao();
+
+            // El primer dibujo del pase siempre fija el estado
+            if (program != bound_program || item == first) { glUseProgram(program);               bound_program = program; counters.program_changes++; }
+            if (texture != bound_texture || item == first) { glBindTexture(GL_TEXTURE_2D, texture); bound_texture = texture; counters.texture_changes++; }
+            if (vao     != bound_vao     || item == first) { glBindVertexArray(vao);               bound_vao     = vao;     counters.vao_changes++;     }
+
+            Frame_Uniforms::bind_object(mesh.get_object_slot());
+
+            geometry.draw_bound(mesh.get_lod());
+
+            counters.draws++;
+        }
+
+        glBindVertexArray(0);
+    }
+}
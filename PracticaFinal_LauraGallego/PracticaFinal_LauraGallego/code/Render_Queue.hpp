@@ -0,0 +1,82 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glad/gl.h>
+
+namespace udit
+{
+    class Mesh;
+
+    // Cola de dibujos del frame. Cada malla visible entra con una clave de 64 bits que
+    // resume su pase, su estado de GPU y su profundidad; la cola se ordena por radix y
+    // se envía cambiando de programa, textura o VAO solo cuando la clave lo indica.
+    //
+    //   Opacos:        pase | programa | textura | VAO | profundidad   (delante a atrás)
+    //   Transparentes: pase | profundidad invertida | programa | textura | VAO
+    //
+    // Los opacos se agrupan por estado y, dentro de cada grupo, de cerca a lejos para
+    // aprovechar el descarte temprano por profundidad; los transparentes van de lejos a
+    // cerca para que la mezcla sea correcta.
+    class Render_Queue
+    {
+    public:
+
+        enum Pass
+        {
+            OPAQUE      = 0,
+            TRANSPARENT = 1
+        };
+
+        struct Statistics
+        {
+            size_t draws           = 0;
+            size_t program_changes = 0;
+            size_t texture_changes = 0;
+            size_t vao_changes     = 0;
+
+            size_t get_state_changes() const { return program_changes + texture_changes + vao_changes; }
+        };
+
+    private:
+
+        struct Item
+        {
+            uint64_t    key;
+            const Mesh* mesh;
+        };
+
+        std::vector<Item> items;
+        std::vector<Item> scratch;          // Destino alterno de cada pasada del radix
+
+        float      far_distance;            // Distancia que corresponde a la profundidad máxima
+        Statistics statistics;
+
+    public:
+
+        Render_Queue() : far_distance(1.0f) {}
+
+        // Vacía la cola y las estadísticas; far_distance fija la escala de la profundidad
+        void begin(float far_distance);
+
+        // La malla ya debe tener su rango del bloque Object del frame
+        void add(const Mesh& mesh, Pass pass, float distance);
+
+        void sort();
+
+        // Dibuja los elementos del pase en el orden de sus claves. Con depth_only se usa el
+        // programa de profundidad de cada malla, sin textura, y no se cuenta en las estadísticas
+        void submit(Pass pass, bool depth_only = false);
+
+        size_t            size          () const { return items.size(); }
+        const Statistics& get_statistics() const { return statistics;   }
+
+    private:
+
+        uint64_t make_key(Pass pass, GLuint program, GLuint texture, GLuint vao, float distance) const;
+    };
+}
@@ -0,0 +1,226 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#include "Resource_Cache.hpp"
+#include "Asset_Loader.hpp"
+#include "Trace.hpp"
+#include <algorithm>
+#include <iostream>
+#include <SOIL2.h>
+
+namespace udit
+{
+    namespace
+    {
+        // FNV-1a de 64 bits
+        uint64_t hash_sources(const std::string& sources)
+        {
+            uint64_t hash = 14695981039346656037ull;
+
+            for (unsigned char c : sources)
+            {
+                hash ^= c;
+                hash *= 1099511628211ull;
+            }
+
+            return hash;
+        }
+
+        std::string get_shader_log(GLuint shader_id)
+        {
+            GLint length = 0;
+            glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &length);
+
+            std::string log(size_t(std::max(length, 1)), '\0');
+            glGetShaderInfoLog(shader_id, length, NULL, &log.front());
+
+            return log;
+        }
+
+        std::string get_program_log(GLuint program_id)
+        {
+            GLint length = 0;
+            glGetProgramiv(program_id, GL_INFO_LOG_LENGTH, &length);
+
+            std::string log(size_t(std::max(length, 1)), '\0');
+            glGetProgramInfoLog(program_id, length, NULL, &log.front());
+
+            return log;
+        }
+
+        // 0 si algún shader no compila o el programa no enlaza (el error se muestra)
+        GLuint compile_program(const char* vertex_source, const char* fragment_source)
+        {
+            GLuint v = glCreateShader(GL_VERTEX_SHADER); glShaderSource(v, 1, &vertex_source, NULL); glCompileShader(v);
+            GLuint f = glCreateShader(GL_FRAGMENT_SHADER); glShaderSource(f, 1, &fragment_source, NULL); glCompileShader(f);
+
+            GLint vertex_compiled = GL_FALSE, fragment_compiled = GL_FALSE, linked = GL_FALSE;
+
+            glGetShaderiv(v, GL_COMPILE_STATUS, &vertex_compiled);
+            glGetShaderiv(f, GL_COMPILE_STATUS, &fragment_compiled);
+
+            if (!vertex_compiled  ) std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n"   << get_shader_log(v).c_str() << std::endl;
+            if (!fragment_compiled) std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << get_shader_log(f).c_str() << std::endl;
+
+            GLuint program_id = glCreateProgram();
+            glAttachShader(program_id, v); glAttachShader(program_id, f); glLinkProgram(program_id);
+            glDeleteShader(v); glDeleteShader(f);
+
+            glGetProgramiv(program_id, GL_LINK_STATUS, &linked);
+
+            if (!linked)
+            {
+                std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << get_program_log(program_id).c_str() << std::endl;
+
+                glDeleteProgram(program_id);
+                return 0;
+            }
+
+            return program_id;
+        }
+
+        // Un mismo modelo puede estar cargado a la vez en ambos formatos
+        std::string geometry_key(const std::string& path, Vertex_Format format)
+        {
+            return path + (format == Vertex_Format::COMPACT ? "|compact" : "|full");
+        }
+    }
+
+    Resource_Cache& Resource_Cache::instance()
+    {
+        static Resource_Cache cache;
+        return cache;
+    }
+
+    void Resource_Cache::request_geometry(const std::string& path, Vertex_Format format, Geometry_Callback on_ready)
+    {
+        const std::string key = geometry_key(path, format);
+
+        if (std::shared_ptr<Geometry> geometry = geometries[key].lock())
+        {
+            statistics.geometry_hits++;
+            on_ready(geometry);
+            return;
+        }
+
+        std::vector<Geometry_Callback>& waiting = pending_geometries[key];
+
+        waiting.push_back(std::move(on_ready));
+
+        if (waiting.size() > 1)
+        {
+            statistics.geometry_hits++;
+            return;
+        }
+
+        // Importación en un hilo de trabajo; la subida y los avisos, en el hilo de OpenGL.
+        // El formato viaja con la petición: es el que había cuando se pidió la geometría.
+        Asset_Loader::instance().submit([this, path, format, key] () -> Asset_Loader::Upload
+        {
+            std::shared_ptr<Geometry::Data> data = std::make_shared<Geometry::Data>();
+
+            bool imported = Geometry::import(path, format, *data);
+
+            return [this, key, data, imported]
+            {
+                std::shared_ptr<Geometry> geometry = imported ? Geometry::create(*data) : nullptr;
+
+                if (geometry) statistics.geometry_loads++;
+
+                geometries[key] = geometry;
+
+                std::vector<Geometry_Callback> callbacks = std::move(pending_geometries[key]);
+                pending_geometries.erase(key);
+
+                for (Geometry_Callback& callback : callbacks) callback(geometry);
+            };
+        });
+    }
+
+    void Resource_Cache::request_texture(const std::string& path, Texture_Callback on_ready)
+    {
+        if (std::shared_ptr<Texture> texture = textures[path].lock())
+        {
+            statistics.texture_hits++;
+            on_ready(texture);
+            return;
+        }
+
+        std::vector<Texture_Callback>& waiting = pending_textures[path];
+
+        waiting.push_back(std::move(on_ready));
+
+        if (waiting.size() > 1)
+        {
+            statistics.texture_hits++;
+            return;
+        }
+
+        // Decodificación con SOIL en un hilo de trabajo
+        Asset_Loader::instance().submit([this, path] () -> Asset_Loader::Upload
+        {
+            UDIT_TRACE_SCOPE("Resource_Cache::decode_texture");
+
+            int width = 0, height = 0, channels = 0;
+
+            unsigned char* pixels = SOIL_load_image(path.c_str(), &width, &height, &channels, SOIL_LOAD_AUTO);
+
+            return [this, path, pixels, width, height, channels] () mutable
+            {
+                std::shared_ptr<Texture> texture;
+
+                if (pixels)
+                {
+                    // Misma creación que SOIL_load_OGL_texture, pero a partir de los píxeles ya decodificados
+                    GLuint texture_id = SOIL_create_OGL_texture(pixels, &width, &height, channels, SOIL_CREATE_NEW_ID, SOIL_FLAG_MIPMAPS);
+
+                    SOIL_free_image_data(pixels);
+
+                    if (texture_id != 0)
+                    {
+                        texture = std::make_shared<Texture>(texture_id);
+                        statistics.texture_loads++;
+                    }
+                }
+
+                if (!texture) std::cout << "ERROR: No se pudo cargar la textura (" << path << ")" << std::endl;
+
+                textures[path] = texture;
+
+                std::vector<Texture_Callback> callbacks = std::move(pending_textures[path]);
+                pending_textures.erase(path);
+
+                for (Texture_Callback& callback : callbacks) callback(texture);
+            };
+        });
+    }
+
+    std::shared_ptr<Shader_Program> Resource_Cache::get_program(const char* vertex_source, const char* fragment_source)
+    {
+        std::string sources = std::string(vertex_source) + '\0' + fragment_source;
+
+        Program_Entry& entry = programs[hash_sources(sources)];
+
+        std::shared_ptr<Shader_Program> program = entry.program.lock();
+
+        if (program && entry.sources == sources)
+        {
+            statistics.program_hits++;
+            return program;
+        }
+
+        program = std::make_shared<Shader_Program>(compile_program(vertex_source, fragment_source));
+
+        statistics.program_compiles++;
+
+        // Un programa que no compila no se guarda (se reintenta en la siguiente petición);
+        // si el hash colisiona con otro programa vivo, el nuevo no se comparte
+        if (program->get_id() != 0 && !entry.program.lock())
+        {
+            entry.sources = std::move(sources);
+            entry.program = program;
+        }
+
+        return program;
+    }
+}
@@ -0,0 +1,110 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+#include "Geometry.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glad/gl.h>
+
+namespace udit
+{
+    // Textura 2D de la GPU; se libera con la última referencia
+    class Texture
+    {
+    private:
+
+        GLuint texture_id;
+
+    public:
+
+        explicit Texture(GLuint id) : texture_id(id) {}
+       ~Texture() { glDeleteTextures(1, &texture_id); }
+
+        Texture(const Texture&) = delete;
+        Texture& operator=(const Texture&) = delete;
+
+        GLuint get_id() const { return texture_id; }
+    };
+
+    // Programa enlazado a partir de un par de fuentes vertex/fragment
+    class Shader_Program
+    {
+    private:
+
+        GLuint program_id;
+
+    public:
+
+        explicit Shader_Program(GLuint id) : program_id(id) {}
+       ~Shader_Program() { glDeleteProgram(program_id); }
+
+        Shader_Program(const Shader_Program&) = delete;
+        Shader_Program& operator=(const Shader_Program&) = delete;
+
+        GLuint get_id() const { return program_id; }
+    };
+
+    // Caché de recursos de GPU con cuenta de referencias. Las geometrías se indexan por
+    // ruta y formato de vértice, las texturas por ruta y los programas por el hash de sus
+    // fuentes; un recurso se
+    // destruye cuando la última malla que lo usa suelta su shared_ptr.
+    //
+    // Geometrías y texturas se cargan de forma asíncrona con Asset_Loader: las
+    // peticiones repetidas de un recurso que aún está cargándose esperan a la misma carga.
+    class Resource_Cache
+    {
+    public:
+
+        // Se llaman en el hilo de OpenGL; reciben nullptr si la carga falla
+        using Geometry_Callback = std::function<void(const std::shared_ptr<Geometry>&)>;
+        using Texture_Callback  = std::function<void(const std::shared_ptr<Texture >&)>;
+
+        struct Statistics
+        {
+            unsigned geometry_loads   = 0, geometry_hits = 0;
+            unsigned texture_loads    = 0, texture_hits  = 0;
+            unsigned program_compiles = 0, program_hits  = 0;
+        };
+
+    private:
+
+        struct Program_Entry
+        {
+            std::string                   sources;          // Para descartar colisiones del hash
+            std::weak_ptr<Shader_Program> program;
+        };
+
+        std::unordered_map<std::string, std::weak_ptr<Geometry>> geometries;
+        std::unordered_map<std::string, std::weak_ptr<Texture>>  textures;
+        std::unordered_map<uint64_t,    Program_Entry>           programs;
+
+        std::unordered_map<std::string, std::vector<Geometry_Callback>> pending_geometries;
+        std::unordered_map<std::string, std::vector<Texture_Callback >> pending_textures;
+
+        Statistics statistics;
+
+    public:
+
+        static Resource_Cache& instance();
+
+        // Si el recurso ya está cargado, on_ready se llama inmediatamente
+        void request_geometry(const std::string& path, Vertex_Format format, Geometry_Callback on_ready);
+        void request_texture (const std::string& path, Texture_Callback  on_ready);
+
+        // Los programas se compilan en el momento (solo en el hilo de OpenGL). Si fallan,
+        // el error se muestra y se devuelve un programa con id 0 que no se guarda.
+        std::shared_ptr<Shader_Program> get_program(const char* vertex_source, const char* fragment_source);
+
+        const Statistics& get_statistics() const { return statistics; }
+
+    private:
+
+        Resource_Cache() = default;
+    };
+}
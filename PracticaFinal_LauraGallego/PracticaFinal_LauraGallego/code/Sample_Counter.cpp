@@ -0,0 +1,59 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#include "Sample_Counter.hpp"
+
+namespace udit
+{
+    Sample_Counter::Sample_Counter() : pending{}, current_frame(0), active(false), last_samples(0)
+    {
+        glGenQueries(frames_in_flight, queries);
+    }
+
+    Sample_Counter::~Sample_Counter()
+    {
+        glDeleteQueries(frames_in_flight, queries);
+    }
+
+    void Sample_Counter::begin()
+    {
+        if (active) return;
+
+        // Antes de reutilizar el hueco más antiguo se recogen los resultados que ya estén listos
+        for (unsigned i = 1; i <= frames_in_flight; ++i)
+        {
+            collect((current_frame + i) % frames_in_flight);
+        }
+
+        current_frame = (current_frame + 1) % frames_in_flight;
+
+        glBeginQuery(GL_SAMPLES_PASSED, queries[current_frame]);
+
+        active = true;
+    }
+
+    void Sample_Counter::end()
+    {
+        if (!active) return;
+
+        glEndQuery(GL_SAMPLES_PASSED);
+
+        pending[current_frame] = true;
+        active                 = false;
+    }
+
+    void Sample_Counter::collect(unsigned frame)
+    {
+        if (!pending[frame]) return;
+
+        GLint available = 0;
+        glGetQueryObjectiv(queries[frame], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return;
+
+        GLuint64 samples = 0;
+        glGetQueryObjectui64v(queries[frame], GL_QUERY_RESULT, &samples);
+
+        last_samples   = samples;
+        pending[frame] = false;
+    }
+}
@@ -0,0 +1,48 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+#include <glad/gl.h>
+#include <cstdint>
+
+namespace udit
+{
+    // Cuenta los fragmentos que superan la prueba de profundidad entre begin() y end()
+    // con una consulta GL_SAMPLES_PASSED por frame. Como Gpu_Profiler, reparte las
+    // consultas en un anillo y solo lee las de frames ya terminados, sin esperar a la GPU.
+    // Las consultas de este tipo no se pueden anidar: un solo intervalo por frame.
+    class Sample_Counter
+    {
+    public:
+
+        static constexpr unsigned frames_in_flight = 4;
+
+    private:
+
+        GLuint   queries[frames_in_flight];
+        bool     pending[frames_in_flight];
+        unsigned current_frame;
+        bool     active;
+
+        uint64_t last_samples;              // Último resultado disponible
+
+    public:
+
+        Sample_Counter();
+       ~Sample_Counter();
+
+        Sample_Counter(const Sample_Counter&) = delete;
+        Sample_Counter& operator=(const Sample_Counter&) = delete;
+
+        void begin();
+        void end();
+
+        // Fragmentos del frame más reciente cuyo resultado ya ha llegado
+        uint64_t get_samples() const { return last_samples; }
+
+    private:
+
+        void collect(unsigned frame);
+    };
+}
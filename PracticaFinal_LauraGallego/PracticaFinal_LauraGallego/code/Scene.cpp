@@ -1,7 +1,10 @@
-// Este cdigo es de dominio pblico
+// Este código es de dominio público
 // penterrin@gmail.com
 
 #include "Scene.hpp"
+#include "Asset_Loader.hpp"
+#include "Geometry_Buffer.hpp"
+#include "Trace.hpp"
 #include <iostream>
 #include <vector>
 #include <fstream>
@@ -10,12 +13,31 @@
 
 namespace udit
 {
+    namespace
+    {
+        // Error geométrico admitido al elegir el nivel de detalle de una malla
+        const float MAX_LOD_ERROR_PIXELS = 1.0f;
+
+        // Tamaño máximo en pantalla de una celda de la rejilla del terreno
+        const float MAX_TERRAIN_CELL_PIXELS = 8.0f;
+
+        // Niebla exponencial: color en rgb y densidad en a
+        const glm::vec4 FOG(0.5f, 0.5f, 0.5f, 0.04f);
+    }
+
     Scene::Scene(int width, int height)
         : camera(0.1f, 1000.f, float(width) / height),
-        skybox("assets/skybox/sky-cube-map-"),
+        skybox("assets/Skybox/sky-cube-map-"),
+        cat_opaque(nullptr), cat_ghost(nullptr),
         terrain(nullptr),main_light(nullptr),
         width(width), height(height),
-        angle_delta_x(0), angle_delta_y(0), pointer_pressed(false), current_effect(0)
+        current_effect(0), elapsed_time(0.f), output_framebuffer_id(0),
+        terrain_visible(true), visible_count(0), culled_count(0),
+        instancing_enabled(true), lod_enabled(true), mesh_triangle_count(0), loading(true),
+        depth_prepass_enabled(true),
+        framebuffer_id(0), texture_colorbuffer_id(0), rbo_id(0),
+        oit_enabled(false), oit_accumulation_id(0), oit_weight_id(0), oit_resolve_shader_id(0),
+        angle_delta_x(0), angle_delta_y(0), pointer_pressed(false)
     {
         
         glEnable(GL_DEPTH_TEST);
@@ -24,18 +46,22 @@ namespace udit
         
         load_scene_from_file("assets/scene.txt");
 
-        // Configuracin por defecto de la cmara (si no estaba en el archivo)
+        // Configuración por defecto de la cámara (si no estaba en el archivo)
         camera.set_location(0.0f, 10.0f, 15.0f);
         camera.set_target(0.0f, 0.0f, 0.0f);
 
-        // Preparacin del Framebuffer para efectos de post-proceso 
+        // Preparación del Framebuffer para efectos de post-proceso 
         init_screen_quad();
         compile_screen_shader();
+        compile_oit_resolve_shader();
         init_framebuffer();
     }
 
     Scene::~Scene()
     {
+        // Las cargas en vuelo guardan punteros a mallas, terreno y skybox
+        Asset_Loader::instance().wait_all();
+
         for (Mesh* m : meshes) {
             delete m;
         }
@@ -48,17 +74,35 @@ namespace udit
         
         glDeleteFramebuffers(1, &framebuffer_id);
         glDeleteTextures(1, &texture_colorbuffer_id);
+        glDeleteTextures(1, &oit_accumulation_id);
+        glDeleteTextures(1, &oit_weight_id);
         glDeleteRenderbuffers(1, &rbo_id);
+        glDeleteProgram(oit_resolve_shader_id);
     }
 
     void Scene::update(float delta_time, const bool* keys)
     {
-        // Control de movimiento de cmara libre (WASD)
+        UDIT_TRACE_SCOPE("Scene::update");
+
+        // Subidas a la GPU de los recursos que han terminado de cargarse (con presupuesto
+        // por frame para que la escena vaya apareciendo sin bloquear la ventana)
+        if (loading) {
+            Asset_Loader::instance().process_uploads(4.0);
+
+            if (!Asset_Loader::instance().is_loading()) {
+                loading = false;
+                print_resource_statistics();
+            }
+        }
+
+        // Control de movimiento de cámara libre (WASD)
+
+        elapsed_time += delta_time;
 
         float speed = 5.0f * delta_time;
         if (keys[SDL_SCANCODE_LSHIFT]) speed *= 2.0f;
 
-        // clculo de vectores
+        // cálculo de vectores
         glm::vec3 front = glm::normalize(glm::vec3(camera.get_target() - camera.get_location()));
         glm::vec3 right = glm::normalize(glm::cross(front, glm::vec3(0, 1, 0)));
         
@@ -68,14 +112,14 @@ namespace udit
         if (keys[SDL_SCANCODE_A]) camera.move(-right * speed);
         if (keys[SDL_SCANCODE_D]) camera.move(right * speed);
 
-        // Rotacin de cmara mediante ratn
+        // Rotación de cámara mediante ratón
         if (angle_delta_x != 0 || angle_delta_y != 0) {
             camera.rotate(glm::rotate(glm::mat4(1.f), angle_delta_x * 0.05f, glm::vec3(0, 1, 0)));
             camera.rotate(glm::rotate(glm::mat4(1.f), angle_delta_y * 0.05f, right));
             angle_delta_x *= 0.9f; angle_delta_y *= 0.9f;
         }
 
-        // Animacin: Rotacin continua del modelo opaco
+        // Animación: Rotación continua del modelo opaco
         if (cat_opaque) {
             glm::vec3 rot = cat_opaque->get_rotation();
             rot.y += 50.0f * delta_time; 
@@ -83,62 +127,148 @@ namespace udit
            
         }
 
-        // Animacin: Levitacin y giro del gato fantasma
+        // Animación: Levitación y giro del gato fantasma
         if (cat_ghost) {
             glm::vec3 rot = cat_ghost->get_rotation();
             rot.y -= 50.0f * delta_time; 
             cat_ghost->set_rotation(rot);
-            float time = SDL_GetTicks() / 1000.0f;
-            float height = 8.0f + sin(time * 2.0f) * 0.5f; // Oscilacin vertical (Seno)
+            float time = elapsed_time;
+            float height = 8.0f + sin(time * 2.0f) * 0.5f; // Oscilación vertical (Seno)
             cat_ghost->set_position({ 2.0f, height, 0.0f });
             
         }
 
-        if (root) root->update();
+        if (root) {
+            root->update();
+            root->update_bounds();
+        }
         
     }
 
     void Scene::render()
     {
+        UDIT_TRACE_SCOPE("Scene::render");
+
+        gpu_profiler.begin_frame();
+
+        cull();
+        prepare_frame();
+
         // PASO 1: Renderizado de la escena en el Framebuffer
         glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id);
         glEnable(GL_DEPTH_TEST);
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Dibujado de objetos bsicos
-        skybox.render(camera);
-        if (terrain) terrain->render(camera);
+        // Las instancias de los opacos se suben una vez y sirven al pre-pase y al color
+        if (instancing_enabled) {
+            instanced_renderer.begin();
+            for (size_t i = 0; i < meshes.size(); ++i) {
+                if (mesh_visible[i] && meshes[i]->get_opacity() >= 0.9f) instanced_renderer.add(*meshes[i]);
+            }
+            instanced_renderer.upload();
+        }
+
+        // Pre-pase de profundidad (tecla Z): terreno y opacos sin color, para que después
+        // cada píxel se sombree una sola vez
+        if (depth_prepass_enabled) {
+            Gpu_Profiler::Scope scope(gpu_profiler, "depth prepass");
+
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+            if (terrain && terrain_visible) terrain->render_depth();
+
+            if (instancing_enabled) instanced_renderer.draw(true);
+            else render_queue.submit(Render_Queue::OPAQUE, true);
+
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+            // La profundidad ya es la definitiva: solo pasan los fragmentos visibles
+            glDepthFunc(GL_LEQUAL);
+            glDepthMask(GL_FALSE);
+        }
+
+        shaded_samples.begin();
+
+        // Dibujado de objetos básicos
+        if (terrain && terrain_visible) {
+            Gpu_Profiler::Scope scope(gpu_profiler, "terrain");
+            terrain->render(camera);
+        }
 
         // --- DIBUJAR TODOS LOS GATOS OPACOS ---
-        // Recorremos la lista y solo dibujamos los que NO son transparentes
-        for (Mesh* m : meshes) {
-            // Si el gato es opaco (casi 1.0), lo dibujamos ahora
-            // Usamos 0.9f como margen de seguridad
-            if (m->get_opacity() >= 0.9f) {
-                m->render(camera);
-            }
+        // Instanciados por grupos de estado o, sin instancing, desde la cola ordenada
+        gpu_profiler.begin("opaque");
+        if (instancing_enabled) {
+            // Un glDrawElementsInstanced por grupo de mallas con el mismo estado
+            instanced_renderer.draw();
+        }
+        else {
+            render_queue.submit(Render_Queue::OPAQUE);
         }
+        gpu_profiler.end();
+
+        // El cielo al final de los opacos, en el plano lejano: solo donde no hay nada delante
+        {
+            Gpu_Profiler::Scope scope(gpu_profiler, "skybox");
+            skybox.render(camera);
+        }
+
+        shaded_samples.end();
+
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
 
         // PASO 2: Dibujado de objetos transparentes (Blending)
         glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         glDepthMask(GL_FALSE); // Desactivamos escritura en Z-Buffer para el blending [cite: 105]
 
         // --- DIBUJAR TODOS LOS GATOS TRANSPARENTES ---
-        // Volvemos a recorrer la lista pero ahora solo dibujamos los "fantasmas"
-        for (Mesh* m : meshes) {
-            if (m->get_opacity() < 0.9f) {
-                m->render(camera);
-            }
+        gpu_profiler.begin("transparent");
+        if (oit_enabled) {
+            // Acumulación en los destinos 1 y 2 sin orden: en rgb se suma y en a se
+            // multiplica (1 - opacidad); OpenGL 3.3 no tiene mezcla por destino
+            static const GLenum OIT_BUFFERS[] = { GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+            static const GLfloat ACCUMULATION_CLEAR[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            static const GLfloat WEIGHT_CLEAR[]       = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+            glDrawBuffers(2, OIT_BUFFERS);
+            glClearBufferfv(GL_COLOR, 0, ACCUMULATION_CLEAR);
+            glClearBufferfv(GL_COLOR, 1, WEIGHT_CLEAR);
+
+            glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+            render_queue.submit(Render_Queue::TRANSPARENT);
+
+            // Composición sobre el color de la escena
+            glDrawBuffer(GL_COLOR_ATTACHMENT0);
+            glDisable(GL_DEPTH_TEST);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+            glUseProgram(oit_resolve_shader_id);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, oit_weight_id);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, oit_accumulation_id);
+            glBindVertexArray(screen_quad_vao);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+            glBindVertexArray(0);
+
+            glEnable(GL_DEPTH_TEST);
+        }
+        else {
+            // Desde la cola, de lejos a cerca, para que la mezcla sea correcta
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            render_queue.submit(Render_Queue::TRANSPARENT);
         }
+        gpu_profiler.end();
 
-        // Restauracin del estado normal de OpenGL
+        // Restauración del estado normal de OpenGL
         glDepthMask(GL_TRUE);
         glDisable(GL_BLEND);
 
         // PASO 3: Post-Proceso (Renderizado del Framebuffer en pantalla)
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        gpu_profiler.begin("post-process");
+        glBindFramebuffer(GL_FRAMEBUFFER, output_framebuffer_id);
         glDisable(GL_DEPTH_TEST);
         glClear(GL_COLOR_BUFFER_BIT);
 
@@ -147,11 +277,130 @@ namespace udit
         glBindVertexArray(screen_quad_vao);
         glBindTexture(GL_TEXTURE_2D, texture_colorbuffer_id);
         glDrawArrays(GL_TRIANGLES, 0, 6);
+        gpu_profiler.end();
+
+        gpu_profiler.end_frame();
     }
 
-    
+    void Scene::cull()
+    {
+        UDIT_TRACE_SCOPE("Scene::cull");
+
+        frustum.set(camera.get_projection_matrix() * camera.get_transform_matrix_inverse());
+
+        // Primero los nodos interiores: un subárbol fuera descarta todas sus mallas
+        if (root) root->cull_hierarchy(frustum);
+
+        mesh_visible.assign(meshes.size(), 0);
+        cull_candidates.clear();
+        cull_x.clear(); cull_y.clear(); cull_z.clear(); cull_radius.clear();
+
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            // Las mallas que aún se están cargando no tienen volumen que probar
+            if (!meshes[i]->get_geometry()) continue;
+
+            Node* parent = meshes[i]->get_parent();
+            if (parent && parent->is_subtree_culled()) continue;
+
+            const Sphere& sphere = meshes[i]->get_world_sphere();
+            cull_candidates.push_back(i);
+            cull_x.push_back(sphere.center.x);
+            cull_y.push_back(sphere.center.y);
+            cull_z.push_back(sphere.center.z);
+            cull_radius.push_back(sphere.radius);
+        }
+
+        // Después las esferas de las mallas supervivientes, cuatro por prueba
+        cull_result.resize(cull_candidates.size());
+        visible_count = frustum.test_spheres(cull_x.data(), cull_y.data(), cull_z.data(), cull_radius.data(), cull_result.data(), cull_candidates.size());
+
+        for (size_t c = 0; c < cull_candidates.size(); ++c) {
+            mesh_visible[cull_candidates[c]] = cull_result[c];
+        }
+
+        // Nivel de detalle de las mallas visibles según su error proyectado
+        mesh_triangle_count = 0;
+
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            if (!mesh_visible[i]) continue;
+
+            if (lod_enabled) meshes[i]->update_lod(camera, float(height), MAX_LOD_ERROR_PIXELS);
+            else             meshes[i]->reset_lod();
+
+            mesh_triangle_count += meshes[i]->get_geometry()->get_lods()[meshes[i]->get_lod()].index_count / 3;
+        }
+
+        terrain_visible = terrain && frustum.intersects(terrain->get_world_bounds());
+
+        // Dentro del terreno, los nodos del quadtree que caen en la pirámide con su nivel
+        if (terrain_visible) {
+            terrain->select(camera, frustum, float(height), MAX_TERRAIN_CELL_PIXELS);
+            terrain_visible = terrain->get_patch_count() > 0;
+        }
+
+        size_t total  = meshes.size() + (terrain ? 1 : 0);
+        visible_count += terrain_visible ? 1 : 0;
+        culled_count   = total - visible_count;
+    }
+
+    void Scene::prepare_frame()
+    {
+        UDIT_TRACE_SCOPE("Scene::prepare_frame");
+
+        // Una sola luz para toda la escena; sin LIGHT en el archivo, la de siempre
+        glm::vec3 light_position = main_light ? main_light->get_position() : glm::vec3(5.0f, 50.0f, 5.0f);
+        glm::vec3 light_color    = main_light ? main_light->get_color   () : glm::vec3(1.0f, 1.0f, 1.0f);
+
+        frame_uniforms.set_frame(camera, light_position, light_color, FOG);
+
+        // Datos de cada dibujo del frame y cola de las mallas que no van instanciadas
+        // (las opacas con instancing llevan los suyos en el buffer de instancias)
+        frame_uniforms.begin_objects();
+        render_queue  .begin(camera.get_far_z());
+
+        if (terrain && terrain_visible) {
+            terrain->set_object_slot(frame_uniforms.add_object(terrain->get_object_data()));
+        }
+
+        glm::vec3 eye = glm::vec3(camera.get_location());
+
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            if (!mesh_visible[i]) continue;
+
+            Mesh* m = meshes[i];
+
+            // Usamos 0.9f como margen de seguridad para considerar opaco un gato
+            bool transparent = m->get_opacity() < 0.9f;
+
+            if (instancing_enabled && !transparent) continue;
+
+            Frame_Uniforms::Object object = m->get_object_data();
+
+            // Con OIT la mezcla no depende del orden: distancia nula y la cola solo agrupa por estado
+            float distance = glm::length(m->get_world_sphere().center - eye);
+
+            if (transparent && oit_enabled) {
+                object.parameters.y = 1.0f;
+                distance = 0.0f;
+            }
+
+            m->set_object_slot(frame_uniforms.add_object(object));
+
+            render_queue.add(*m, transparent ? Render_Queue::TRANSPARENT : Render_Queue::OPAQUE, distance);
+        }
+
+        frame_uniforms.end_objects();
+        render_queue  .sort();
+    }
 
     void Scene::init_framebuffer() {
+        // Al redimensionar se sustituyen los destinos anteriores
+        glDeleteFramebuffers(1, &framebuffer_id);
+        glDeleteTextures(1, &texture_colorbuffer_id);
+        glDeleteTextures(1, &oit_accumulation_id);
+        glDeleteTextures(1, &oit_weight_id);
+        glDeleteRenderbuffers(1, &rbo_id);
+
         glGenFramebuffers(1, &framebuffer_id);
         glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id);
 
@@ -163,6 +412,24 @@ namespace udit
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture_colorbuffer_id, 0);
 
+        // Destinos de la transparencia OIT; se leen texel a texel en la composición
+        glGenTextures(1, &oit_accumulation_id);
+        glBindTexture(GL_TEXTURE_2D, oit_accumulation_id);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_HALF_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, oit_accumulation_id, 0);
+
+        glGenTextures(1, &oit_weight_id);
+        glBindTexture(GL_TEXTURE_2D, oit_weight_id);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, width, height, 0, GL_RED, GL_HALF_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, oit_weight_id, 0);
+
+        // Fuera del pase OIT solo se escribe el color de la escena
+        glDrawBuffer(GL_COLOR_ATTACHMENT0);
+
         
         glGenRenderbuffers(1, &rbo_id);
         glBindRenderbuffer(GL_RENDERBUFFER, rbo_id);
@@ -248,6 +515,50 @@ namespace udit
         glDeleteShader(v); glDeleteShader(f);
     }
 
+    void Scene::compile_oit_resolve_shader() {
+        const char* vShader = R"(
+            #version 330 core
+            layout (location = 0) in vec2 aPos;
+            void main() {
+                gl_Position = vec4(aPos.x, aPos.y, 0.0, 1.0);
+            }
+        )";
+
+        const char* fShader = R"(
+            #version 330 core
+            out vec4 FragColor;
+
+            uniform sampler2D accumulationTexture;
+            uniform sampler2D weightTexture;
+
+            void main() {
+                ivec2 texel = ivec2(gl_FragCoord.xy);
+
+                vec4  accumulation = texelFetch(accumulationTexture, texel, 0);
+                float revealage    = accumulation.a;
+
+                // Ningún fragmento transparente en este píxel
+                if (revealage >= 1.0) discard;
+
+                float weight = texelFetch(weightTexture, texel, 0).r;
+
+                // Color medio ponderado, cubriendo según lo que no deja pasar la pila
+                FragColor = vec4(accumulation.rgb / max(weight, 1e-5), 1.0 - revealage);
+            }
+        )";
+
+        GLuint v = glCreateShader(GL_VERTEX_SHADER); glShaderSource(v, 1, &vShader, NULL); glCompileShader(v);
+        GLuint f = glCreateShader(GL_FRAGMENT_SHADER); glShaderSource(f, 1, &fShader, NULL); glCompileShader(f);
+        oit_resolve_shader_id = glCreateProgram();
+        glAttachShader(oit_resolve_shader_id, v); glAttachShader(oit_resolve_shader_id, f); glLinkProgram(oit_resolve_shader_id);
+        glDeleteShader(v); glDeleteShader(f);
+
+        glUseProgram(oit_resolve_shader_id);
+        glUniform1i(glGetUniformLocation(oit_resolve_shader_id, "accumulationTexture"), 0);
+        glUniform1i(glGetUniformLocation(oit_resolve_shader_id, "weightTexture"), 1);
+        glUseProgram(0);
+    }
+
     void Scene::resize(int w, int h) {
         width = w; height = h;
         camera.set_ratio(float(width) / height);
@@ -268,9 +579,56 @@ namespace udit
             if (current_effect == 1) std::cout << "MODO: Sepia" << std::endl;
             if (current_effect == 2) std::cout << "MODO: Vision Nocturna" << std::endl;
         }
+
+        // Alternancia entre dibujado instanciado y una llamada por malla
+        if (key == SDLK_I)
+        {
+            instancing_enabled = !instancing_enabled;
+            std::cout << "INSTANCING: " << (instancing_enabled ? "Activado" : "Desactivado") << std::endl;
+        }
+
+        // Niveles de detalle de las mallas activados o siempre la malla completa
+        if (key == SDLK_L)
+        {
+            lod_enabled = !lod_enabled;
+            std::cout << "LOD: " << (lod_enabled ? "Activado" : "Desactivado") << std::endl;
+        }
+
+        // Transparencia ordenada de lejos a cerca o weighted blended OIT
+        if (key == SDLK_O)
+        {
+            oit_enabled = !oit_enabled;
+            std::cout << "TRANSPARENCIA: " << (oit_enabled ? "OIT ponderada" : "Ordenada") << std::endl;
+        }
+
+        // Pre-pase de profundidad de terreno y opacos
+        if (key == SDLK_Z)
+        {
+            depth_prepass_enabled = !depth_prepass_enabled;
+            std::cout << "PRE-PASE DE PROFUNDIDAD: " << (depth_prepass_enabled ? "Activado" : "Desactivado") << std::endl;
+        }
+
+        // Volcado de los tiempos de GPU por pase
+        if (key == SDLK_P)
+        {
+            gpu_profiler.dump(std::cout);
+            std::cout << "Culling: " << visible_count << " visibles, " << culled_count << " descartados" << std::endl;
+            std::cout << "Triangulos de mallas: " << mesh_triangle_count << std::endl;
+            if (terrain) std::cout << "Terreno: " << (terrain_visible ? terrain->get_patch_count() : 0) << " parches, "
+                                   << (terrain_visible ? terrain->get_triangle_count() : 0) << " triangulos" << std::endl;
+            std::cout << "Fragmentos opacos sombreados: " << shaded_samples.get_samples() << " ("
+                      << double(shaded_samples.get_samples()) / (double(width) * height) << " por pixel)" << std::endl;
+            print_geometry_buffer_statistics();
+
+            const Render_Queue::Statistics& queue = render_queue.get_statistics();
+            std::cout << "Cola de dibujo: " << queue.draws << " dibujos, " << queue.get_state_changes() << " cambios de estado ("
+                      << queue.program_changes << " programas, " << queue.texture_changes << " texturas, " << queue.vao_changes << " VAO)" << std::endl;
+        }
     }
 
     void Scene::load_scene_from_file(const std::string& file_path) {
+        UDIT_TRACE_SCOPE("Scene::load_scene_from_file");
+
         std::ifstream file(file_path);
 
         if (!file.is_open()) {
@@ -278,9 +636,12 @@ namespace udit
             return;
         }
 
+        // Formato de los modelos; VERTEX_FORMAT lo cambia para las líneas siguientes
+        Vertex_Format vertex_format = Vertex_Format::COMPACT;
+
         std::string line;
         while (std::getline(file, line)) {
-            if (line.empty() || line[0] == '#') continue; // Saltar vacos y comentarios
+            if (line.empty() || line[0] == '#') continue; // Saltar vacíos y comentarios
 
             std::stringstream ss(line);
             std::string type;
@@ -292,10 +653,10 @@ namespace udit
                 std::string path;
                 ss >> w >> d >> xs >> zs >> path;
 
-                // Creamos el terreno con los datos ledos
+                // Creamos el terreno con los datos leídos
                 terrain = new Terrain(w, d, xs, zs, path);
                 terrain->set_position({ 0.0f, -2.0f, 0.0f });
-                root->add_child(terrain);// Podras leer la posicin tambin si quieres
+                root->add_child(terrain);// Podrías leer la posición también si quieres
             }
             else if (type == "LIGHT") {
                 float x, y, z, r, g, b;
@@ -306,29 +667,76 @@ namespace udit
                 main_light->set_color({ r, g, b });
                 root->add_child(main_light);
             }
+            else if (type == "VERTEX_FORMAT") {
+                // Formato de vértices de los modelos que se carguen a continuación
+                std::string format;
+                ss >> format;
+
+                vertex_format = format == "FULL" ? Vertex_Format::FULL : Vertex_Format::COMPACT;
+            }
+            else if (type == "MESH_GRID") {
+                // Rejilla de copias del mismo modelo: MESH_GRID ruta columnas filas separacion y opacidad
+                std::string path;
+                int columns, rows;
+                float spacing, y, opacity;
+                ss >> path >> columns >> rows >> spacing >> y >> opacity;
+
+                for (int r = 0; r < rows; ++r) {
+                    for (int c = 0; c < columns; ++c) {
+                        Mesh* new_mesh = new Mesh(path, vertex_format);
+                        new_mesh->set_position({ (c - (columns - 1) * 0.5f) * spacing, y, (r - (rows - 1) * 0.5f) * spacing });
+                        new_mesh->set_opacity(opacity);
+
+                        meshes.push_back(new_mesh);
+                        root->add_child(new_mesh);
+                    }
+                }
+            }
             else if (type == "MESH") {
                 std::string path;
                 float x, y, z, opacity;
                 ss >> path >> x >> y >> z >> opacity;
 
-                Mesh* new_mesh = new Mesh(path);
+                Mesh* new_mesh = new Mesh(path, vertex_format);
                 new_mesh->set_position({ x, y, z });
                 new_mesh->set_opacity(opacity);
 
-                if (main_light) new_mesh->set_light(main_light);
-
                 // IMPORTANTE: Siempre lo guardamos en la lista
                 meshes.push_back(new_mesh);
                 root->add_child(new_mesh);
 
-                // Solo asignamos a las variables de animacin si estn vacas
-                // As el primer gato del TXT ser el que se mueva
+                // Solo asignamos a las variables de animación si están vacías
+                // Así el primer gato del TXT será el que se mueva
                 if (opacity >= 0.9f && cat_opaque == nullptr) cat_opaque = new_mesh;
                 else if (opacity < 0.9f && cat_ghost == nullptr) cat_ghost = new_mesh;
             }
         }
     }
 
+    void Scene::print_resource_statistics()
+    {
+        const Resource_Cache::Statistics& stats = Resource_Cache::instance().get_statistics();
+        std::cout << "Carga completa (" << elapsed_time << " s). "
+                  << "Recursos: " << stats.geometry_loads   << " geometrias cargadas (" << stats.geometry_hits << " compartidas), "
+                                  << stats.texture_loads    << " texturas ("            << stats.texture_hits  << " compartidas), "
+                                  << stats.program_compiles << " programas ("           << stats.program_hits  << " compartidos)" << std::endl;
+
+        print_geometry_buffer_statistics();
+    }
+
+    void Scene::print_geometry_buffer_statistics()
+    {
+        for (const Geometry_Buffer::Statistics& buffer : Geometry_Buffer::get_all_statistics()) {
+            std::cout << "Buffer de geometria (" << (buffer.format == Vertex_Format::COMPACT ? "compacto" : "completo")
+                      << ", indices de " << (buffer.index_type == GL_UNSIGNED_SHORT ? 16 : 32) << " bits): "
+                      << buffer.vertices.used << "/" << buffer.vertices.capacity << " vertices, "
+                      << buffer.indices .used << "/" << buffer.indices .capacity << " indices, "
+                      << buffer.vertices.allocations << " geometrias, "
+                      << "fragmentacion " << buffer.vertices.fragmentation() << " / " << buffer.indices.fragmentation() << ", "
+                      << buffer.resizes << " ampliaciones" << std::endl;
+        }
+    }
+
         void Scene::on_drag(float x, float y) {
             if (pointer_pressed) {
                 angle_delta_x = (last_pointer_x - x) * 0.1f;
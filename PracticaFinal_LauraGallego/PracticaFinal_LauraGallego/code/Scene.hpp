@@ -1,4 +1,4 @@
-// Este cdigo es de dominio pblico
+// Este código es de dominio público
 // penterrin@gmail.com
 
 #ifndef SCENE_HEADER
@@ -9,6 +9,12 @@
     #include "Mesh.hpp"
     #include "Terrain.hpp"
     #include "Light.hpp"
+    #include "Gpu_Profiler.hpp"
+    #include "Frustum.hpp"
+    #include "Instanced_Renderer.hpp"
+    #include "Frame_Uniforms.hpp"
+    #include "Render_Queue.hpp"
+    #include "Sample_Counter.hpp"
     #include <SDL3/SDL.h>
     #include <string>
     #include <vector>
@@ -33,15 +39,53 @@
 
             std::vector<Mesh*> meshes;
 
+            Gpu_Profiler gpu_profiler;
+
             int    width;
             int    height;
 
             int current_effect;
 
+            float  elapsed_time;
+
+            GLuint output_framebuffer_id;
+
+            // Descarte por pirámide de visión (recalculado en cada render)
+            Frustum              frustum;
+            std::vector<size_t>  cull_candidates;      // Índices en meshes a probar por lotes
+            std::vector<float>   cull_x, cull_y, cull_z, cull_radius;
+            std::vector<uint8_t> cull_result;
+            std::vector<uint8_t> mesh_visible;         // Paralelo a meshes
+            bool                 terrain_visible;
+            size_t               visible_count;
+            size_t               culled_count;
+
+            Frame_Uniforms       frame_uniforms;       // Bloques Frame y Object de todos los programas
+            Instanced_Renderer   instanced_renderer;
+            Render_Queue         render_queue;         // Dibujos sueltos del frame, ordenados por clave
+            bool                 instancing_enabled;
+
+            // Niveles de detalle de las mallas (tecla L)
+            bool                 lod_enabled;
+            size_t               mesh_triangle_count;  // Triángulos de malla dibujados en el último render
+
+            bool                 loading;              // Quedan recursos por llegar de Asset_Loader
+
+            // Pre-pase de profundidad (tecla Z) y fragmentos que superan la profundidad en
+            // el pase opaco con color (terreno, mallas y cielo)
+            bool                 depth_prepass_enabled;
+            Sample_Counter       shaded_samples;
+
             GLuint framebuffer_id;
             GLuint texture_colorbuffer_id; 
             GLuint rbo_id;                 
 
+            // Transparencia independiente del orden (tecla O): destinos 1 y 2 del framebuffer
+            bool   oit_enabled;
+            GLuint oit_accumulation_id;    // RGBA16F: rgb = suma de color ponderado, a = producto de revelado
+            GLuint oit_weight_id;          // R16F:    suma de opacidades ponderadas
+            GLuint oit_resolve_shader_id;
+
             GLuint screen_quad_vao;
             GLuint screen_quad_vbo;
             GLuint screen_shader_id;
@@ -58,9 +102,15 @@
             void init_framebuffer();
             void init_screen_quad();
             void compile_screen_shader();
+            void compile_oit_resolve_shader();
 
             void load_scene_from_file(const std::string& file_path);
 
+            void cull();
+            void prepare_frame();
+            void print_resource_statistics();
+            void print_geometry_buffer_statistics();
+
 
         public:
 
@@ -76,6 +126,38 @@
 
             void on_key_down(int key);
 
+            // Acceso a la cámara para recorridos guiados (benchmark)
+            Camera & get_camera () { return camera; }
+
+            // Tiempos de GPU por pase (tecla P para volcarlos en consola)
+            const Gpu_Profiler & get_gpu_profiler () const { return gpu_profiler; }
+
+            // Objetos dibujados y descartados en el último render
+            size_t get_visible_count () const { return visible_count; }
+            size_t get_culled_count  () const { return culled_count;  }
+
+            // Triángulos de las mallas visibles con su nivel de detalle
+            size_t get_mesh_triangle_count () const { return mesh_triangle_count; }
+
+            // Triángulos de los parches de terreno elegidos en el último render
+            size_t get_terrain_triangle_count () const { return terrain && terrain_visible ? terrain->get_triangle_count() : 0; }
+
+            // Cambios de programa, textura y VAO de la cola de dibujo en el último render
+            size_t get_state_changes () const { return render_queue.get_statistics().get_state_changes(); }
+
+            // Fragmentos sombreados en el pase opaco del último resultado disponible
+            uint64_t get_shaded_samples () const { return shaded_samples.get_samples(); }
+
+            bool is_depth_prepass_enabled  () const       { return depth_prepass_enabled;    }
+            void set_depth_prepass_enabled (bool enabled) { depth_prepass_enabled = enabled; }
+
+            // Transparencia ordenada por la cola o weighted blended OIT
+            bool is_oit_enabled  () const        { return oit_enabled;    }
+            void set_oit_enabled (bool enabled)  { oit_enabled = enabled; }
+
+            // Framebuffer de destino del post-proceso (0 = ventana)
+            void set_output_framebuffer (GLuint id) { output_framebuffer_id = id; }
+
         };
 
     }
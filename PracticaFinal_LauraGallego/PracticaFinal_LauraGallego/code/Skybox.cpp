@@ -1,4 +1,4 @@
-// Este cdigo es de dominio pblico
+// Este código es de dominio público
 // penterrin@gmail.com angel.rodriguez@esne.edu
 // 2014.03+
 
@@ -6,6 +6,7 @@
 #include <iostream>
 #include <glad/gl.h>
 #include "Skybox.hpp"
+#include "Frame_Uniforms.hpp"
 
 namespace udit
 {
@@ -55,10 +56,7 @@ namespace udit
 
     const std::string Skybox::vertex_shader_code =
 
-        "#version 330\n"
-        ""
-        "uniform mat4 model_view_matrix;"
-        "uniform mat4 projection_matrix;"
+        std::string("#version 330\n") + Frame_Uniforms::FRAME_BLOCK +
         ""
         "layout (location = 0) in vec3 vertex_coordinates;"
         ""
@@ -67,7 +65,9 @@ namespace udit
         "void main()"
         "{"
         "   texture_coordinates = vec3(vertex_coordinates.x, -vertex_coordinates.y, vertex_coordinates.z);"
-        "   gl_Position = projection_matrix * model_view_matrix * vec4(vertex_coordinates, 1.0);"
+        "   vec4 position = projection * mat4(mat3(view)) * vec4(vertex_coordinates, 1.0);"
+        ""
+        "   gl_Position = position.xyww;"    // z = w: profundidad 1, en el plano lejano
         "}";
 
     const std::string Skybox::fragment_shader_code =
@@ -88,17 +88,17 @@ namespace udit
     :
         texture_cube(texture_base_path)
     {
-        assert(texture_cube.is_ok ());
+        // Las caras se cargan de forma asíncrona: aquí aún no están subidas y render()
+        // no dibuja nada hasta que lo estén
 
-        
-        // Compilacin de shaders especficos para el Skybox
+        // Compilación de shaders específicos para el Skybox
         shader_program_id = compile_shaders ();
 
-        model_view_matrix_id = glGetUniformLocation (shader_program_id, "model_view_matrix");
-        projection_matrix_id = glGetUniformLocation (shader_program_id, "projection_matrix");
+        // Vista y proyección llegan en el bloque Frame
+        Frame_Uniforms::bind_blocks (shader_program_id);
 
         
-        // Generacin de buffers para el cubo
+        // Generación de buffers para el cubo
         glGenBuffers (1, &vbo_id);
         glGenVertexArrays (1, &vao_id);
 
@@ -107,7 +107,7 @@ namespace udit
         glBindVertexArray (vao_id);
 
         
-        // Carga de vrtices del cubo envolvente
+        // Carga de vértices del cubo envolvente
         glBindBuffer (GL_ARRAY_BUFFER, vbo_id);
         glBufferData (GL_ARRAY_BUFFER, sizeof(coordinates), coordinates, GL_STATIC_DRAW);
 
@@ -125,35 +125,30 @@ namespace udit
         glDeleteBuffers      (1, &vbo_id);
     }
 
-    void Skybox::render (const Camera & camera)
+    void Skybox::render (const Camera & /*camera*/)
     {
+        // Las caras del cubo pueden no haber terminado de cargarse
+        if (!texture_cube.is_ok ()) return;
+
         glUseProgram (shader_program_id);
 
-        // Vinculacin de la textura cbica (CubeMap)
+        // Vinculación de la textura cúbica (CubeMap)
         texture_cube.bind ();
 
-        // Obtencin de la matriz de vista sin traslacin (para que el cielo no se mueva al andar)
-        glm::mat4 view = camera.get_transform_matrix_inverse();
-
-        view[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
-
-        const glm::mat4& model_view_matrix = view;
-       
-
-        const glm::mat4& projection_matrix = camera.get_projection_matrix();
-
-        glUniformMatrix4fv(model_view_matrix_id, 1, GL_FALSE, glm::value_ptr(model_view_matrix));
-        glUniformMatrix4fv(projection_matrix_id, 1, GL_FALSE, glm::value_ptr(projection_matrix));
+        // La vista sin traslación (para que el cielo no se mueva al andar) se obtiene
+        // en el vertex shader a partir del bloque Frame
 
-        // Desactivacin de escritura en Z-Buffer
-        // El skybox debe dibujarse siempre "detrs" de todo, sin bloquear otros objetos
+        // Se dibuja tras los opacos en el plano lejano: con GL_LEQUAL solo se sombrean
+        // los píxeles que nada ha cubierto, y sin escribir en el Z-Buffer
+        glDepthFunc(GL_LEQUAL);
         glDepthMask(GL_FALSE);
 
         glBindVertexArray(vao_id);
         glDrawArrays(GL_TRIANGLES, 0, 36);
         
-        // Restauracin de escritura en profundidad
+        // Restauración de escritura en profundidad
         glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
 
         glBindVertexArray(0);
         glUseProgram(0);
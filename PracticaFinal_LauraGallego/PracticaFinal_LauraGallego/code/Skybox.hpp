@@ -1,5 +1,5 @@
 
-// Este cdigo es de dominio pblico
+// Este código es de dominio público
 // penterrin@gmail.com
 
 #ifndef SKYBOX_HEADER
@@ -26,9 +26,6 @@
 
             GLuint       shader_program_id;
 
-            GLint        model_view_matrix_id;
-            GLint        projection_matrix_id;
-
             Texture_Cube texture_cube;
 
         public:
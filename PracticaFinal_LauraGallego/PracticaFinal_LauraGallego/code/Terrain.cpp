@@ -1,208 +1,665 @@
-// Este cdigo es de dominio pblico
+// Este código es de dominio público
 // penterrin@gmail.com
 
 #include "Terrain.hpp"
-#include "Camera.hpp" 
+#include "Camera.hpp"
+#include "Frustum.hpp"
+#include "Trace.hpp"
+#include "Asset_Loader.hpp"
+#include "Thread_Pool.hpp"
+#include <algorithm>
 #include <iostream>
 #include <SOIL2.h>
 #include <gtc/type_ptr.hpp>
-#include <cmath> 
+#include <cmath>
 
 namespace udit
 {
-    Terrain::Terrain(float width, float depth, unsigned x_slices, unsigned z_slices, const std::string& texture_path)
+    namespace
     {
-        // Generacin de malla plana subdividida
-        std::vector<float> coordinates;
-        std::vector<float> uvs;
+        // Hojas por fila a partir de las que las alturas de los nodos se calculan en paralelo
+        const unsigned PARALLEL_LEAF_ROWS = 64;
 
-        for (unsigned z = 0; z < z_slices; ++z)
-        {
-            for (unsigned x = 0; x <= x_slices; ++x)
+        // Parte del rango de cada nivel en la que los vértices ya se deslizan hacia el siguiente
+        const float MORPH_START = 0.66f;
+
+        // Posición en mundo de un vértice del parche, común al pase con color y al de
+        // profundidad para que ambos den exactamente la misma gl_Position. La coordenada
+        // del mapa es también la UV del mapa de alturas; position_scale y position_offset
+        // del bloque Object llevan el tamaño y el origen de la rejilla.
+        const std::string TERRAIN_POSITION = std::string(R"(
+            const float PATCH_SIZE = )") + std::to_string(Terrain::PATCH_SIZE) + R"(.0;
+
+            layout (location = 0) in vec2 aGrid;    // Coordenada entera dentro del parche
+            layout (location = 1) in vec4 aNode;    // Por instancia: origen, tamaño y nivel del nodo
+
+            uniform sampler2D heightMap;
+            uniform float max_height;
+            uniform vec3  camera_local;             // Cámara en espacio del terreno
+            uniform vec2  morph_ranges[)" + std::to_string(Terrain::MAX_LEVELS) + R"(];
+
+            vec3 terrain_local(vec2 uv, out float h)
             {
-                // Clculo de coordenadas UV y posiciones X/Z
-                float u = (float)x / x_slices;
-                float v1 = (float)z / z_slices;
-                float v2 = (float)(z + 1) / z_slices;
+                h = texture(heightMap, uv).r;
+                return vec3(uv.x * position_scale.x + position_offset.x, h * max_height, uv.y * position_scale.z + position_offset.z);
+            }
+
+            vec4 terrain_position(out vec2 uv, out float h)
+            {
+                uv = aNode.xy + aGrid / PATCH_SIZE * aNode.z;
 
-                float xPos = (u * width) - (width * 0.5f);
-                float zPos1 = (v1 * depth) - (depth * 0.5f);
-                float zPos2 = (v2 * depth) - (depth * 0.5f);
+                // Con morph = 1 los vértices impares caen sobre los pares y el parche
+                // coincide con la rejilla del nivel siguiente
+                vec2  range = morph_ranges[int(aNode.w)];
+                float morph = clamp((distance(terrain_local(uv, h), camera_local) - range.x) / (range.y - range.x), 0.0, 1.0);
 
-                coordinates.push_back(xPos); coordinates.push_back(zPos1);
-                uvs.push_back(u); uvs.push_back(v1);
+                uv -= mod(aGrid, 2.0) / PATCH_SIZE * aNode.z * morph;
 
-                coordinates.push_back(xPos); coordinates.push_back(zPos2);
-                uvs.push_back(u); uvs.push_back(v2);
+                return model * vec4(terrain_local(uv, h), 1.0);
             }
+        )";
+
+        // Distancia de un punto a una caja (0 si está dentro)
+        float distance_to(const Aabb& box, const glm::vec3& point)
+        {
+            return glm::length(glm::max(glm::max(box.min - point, point - box.max), glm::vec3(0.0f)));
         }
+    }
 
-        number_of_vertices = coordinates.size() / 2;
+    const unsigned Terrain::PATCH_SIZE;
+    const unsigned Terrain::MAX_LEVELS;
 
-        
-        glGenVertexArrays(1, &vao_id);
-        glGenBuffers(2, vbo_ids);
+    Terrain::Terrain(float width, float depth, unsigned x_slices, unsigned z_slices, const std::string& texture_path)
+        : vao_id(0), vbo_id(0), ebo_id(0), instance_buffer(0), texture_id(0), normal_texture_id(0), depth_program_id(0), patch_index_count(0),
+          level_count(1), camera_local(0.0f), instance_capacity(0), width(width), depth(depth), max_height(8.0f)
+    {
+        local_bounds.extend(glm::vec3(-width * 0.5f, 0.0f,       -depth * 0.5f));
+        local_bounds.extend(glm::vec3( width * 0.5f, max_height,  depth * 0.5f));
 
-        glBindVertexArray(vao_id);
+        // Hojas por lado: potencia de dos de parches que cubre la resolución pedida
+        unsigned leaves = 1;
 
-        
-        glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[0]);
-        glBufferData(GL_ARRAY_BUFFER, coordinates.size() * sizeof(float), coordinates.data(), GL_STATIC_DRAW);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+        while (leaves * PATCH_SIZE < std::max(x_slices, z_slices) && level_count < MAX_LEVELS)
+        {
+            leaves      *= 2;
+            level_count += 1;
+        }
 
-        
-        glBindBuffer(GL_ARRAY_BUFFER, vbo_ids[1]);
-        glBufferData(GL_ARRAY_BUFFER, uvs.size() * sizeof(float), uvs.data(), GL_STATIC_DRAW);
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, 0);
+        compile_shaders();
+        upload_patch();
 
-        glBindVertexArray(0);
+        // Las alturas de los nodos y el mapa se preparan en un hilo de trabajo; hasta que
+        // se suben el terreno no se dibuja
+        Asset_Loader::instance().submit([this, texture_path] () -> Asset_Loader::Upload
+        {
+            UDIT_TRACE_SCOPE("Terrain::generate");
 
-        
-        load_heightmap(texture_path);
-        compile_shaders();
+            int w = 0, h = 0, c = 0;
+            unsigned char* img = SOIL_load_image(texture_path.c_str(), &w, &h, &c, SOIL_LOAD_L);
+
+            auto ranges = std::make_shared< std::vector< std::vector<glm::vec2> > >();
+
+            build_height_ranges(*ranges, level_count, img, w, h, max_height);
+
+            // Copia compacta para las consultas desde la CPU; los pixeles de SOIL se
+            // liberan aquí mismo
+            auto field   = std::make_shared< Heightfield >();
+            auto normals = std::make_shared< std::vector<int8_t> >();
+
+            if (img)
+            {
+                *field = Heightfield(img, w, h);
+                SOIL_free_image_data(img);
+
+                field->build_normal_map(this->width, max_height, this->depth, *normals);
+            }
+
+            return [this, ranges, field, normals, texture_path]
+            {
+                upload_heightmap(*field, *normals, texture_path);
+
+                height_ranges.swap(*ranges);
+                heightfield  .swap(*field);
+            };
+        });
     }
 
     Terrain::~Terrain()
     {
         glDeleteVertexArrays(1, &vao_id);
-        glDeleteBuffers(2, vbo_ids);
+        glDeleteBuffers(1, &vbo_id);
+        glDeleteBuffers(1, &ebo_id);
+        glDeleteBuffers(1, &instance_buffer);
         glDeleteTextures(1, &texture_id);
+        glDeleteTextures(1, &normal_texture_id);
         glDeleteProgram(shader_program_id);
+        glDeleteProgram(depth_program_id);
+    }
+
+    void Terrain::build_height_ranges(std::vector< std::vector<glm::vec2> >& ranges, unsigned level_count, const unsigned char* pixels, int image_width, int image_height, float max_height)
+    {
+        ranges.resize(level_count);
+
+        unsigned leaves = 1u << (level_count - 1);
+
+        std::vector<glm::vec2>& leaf_ranges = ranges.back();
+
+        leaf_ranges.assign(size_t(leaves) * leaves, glm::vec2(0.0f, pixels ? 0.0f : max_height));
+
+        // Hojas: texeles que el filtrado lineal puede mezclar en la región de cada una
+        auto build_leaf_row = [&] (size_t z)
+        {
+            if (!pixels) return;
+
+            float v0 = float(z) / leaves, v1 = float(z + 1) / leaves;
+
+            int ty0 = std::max(int(std::floor(v0 * image_height - 0.5f)), 0), ty1 = std::min(int(std::ceil(v1 * image_height - 0.5f)), image_height - 1);
+
+            for (unsigned x = 0; x < leaves; ++x)
+            {
+                float u0 = float(x) / leaves, u1 = float(x + 1) / leaves;
+
+                int tx0 = std::max(int(std::floor(u0 * image_width - 0.5f)), 0), tx1 = std::min(int(std::ceil(u1 * image_width - 0.5f)), image_width - 1);
+
+                unsigned char low = 255, high = 0;
+
+                for (int y = ty0; y <= ty1; ++y)
+                {
+                    for (int tx = tx0; tx <= tx1; ++tx)
+                    {
+                        unsigned char texel = pixels[size_t(y) * image_width + tx];
+                        low  = std::min(low,  texel);
+                        high = std::max(high, texel);
+                    }
+                }
+
+                leaf_ranges[z * leaves + x] = glm::vec2(low / 255.0f * max_height, high / 255.0f * max_height);
+            }
+        };
+
+        if (leaves >= PARALLEL_LEAF_ROWS) Thread_Pool::instance().parallel_for(leaves, build_leaf_row);
+        else for (unsigned z = 0; z < leaves; ++z) build_leaf_row(z);
+
+        // Cada nodo interior cubre el rango de sus cuatro hijos
+        for (unsigned tree_depth = level_count - 1; tree_depth-- > 0; )
+        {
+            unsigned nodes = 1u << tree_depth;
+
+            const std::vector<glm::vec2>& children = ranges[tree_depth + 1];
+            std::vector<glm::vec2>&       parents  = ranges[tree_depth];
+
+            parents.resize(size_t(nodes) * nodes);
+
+            for (unsigned z = 0; z < nodes; ++z)
+            {
+                for (unsigned x = 0; x < nodes; ++x)
+                {
+                    const glm::vec2& a = children[(2 * z    ) * 2 * nodes + 2 * x];
+                    const glm::vec2& b = children[(2 * z    ) * 2 * nodes + 2 * x + 1];
+                    const glm::vec2& c = children[(2 * z + 1) * 2 * nodes + 2 * x];
+                    const glm::vec2& d = children[(2 * z + 1) * 2 * nodes + 2 * x + 1];
+
+                    parents[z * nodes + x] = glm::vec2(std::min(std::min(a.x, b.x), std::min(c.x, d.x)),
+                                                       std::max(std::max(a.y, b.y), std::max(c.y, d.y)));
+                }
+            }
+        }
+    }
+
+    void Terrain::upload_patch()
+    {
+        // Parche de (PATCH_SIZE + 1)^2 vértices compartidos, una tira por fila
+        const unsigned row_vertices = PATCH_SIZE + 1;
+
+        std::vector<Grid_Vertex> vertices;
+        std::vector<uint16_t>    indices;
+
+        vertices.reserve(row_vertices * row_vertices);
+
+        for (unsigned z = 0; z <= PATCH_SIZE; ++z)
+        {
+            for (unsigned x = 0; x <= PATCH_SIZE; ++x) vertices.push_back({ uint16_t(x), uint16_t(z) });
+        }
+
+        for (unsigned z = 0; z < PATCH_SIZE; ++z)
+        {
+            if (z > 0) indices.push_back(0xFFFF);
+
+            for (unsigned x = 0; x <= PATCH_SIZE; ++x)
+            {
+                indices.push_back(uint16_t( z      * row_vertices + x));
+                indices.push_back(uint16_t((z + 1) * row_vertices + x));
+            }
+        }
+
+        patch_index_count = GLsizei(indices.size());
+
+        glGenVertexArrays(1, &vao_id);
+        glGenBuffers(1, &vbo_id);
+        glGenBuffers(1, &ebo_id);
+        glGenBuffers(1, &instance_buffer);
+
+        glBindVertexArray(vao_id);
+
+        // Coordenadas enteras sin normalizar: el shader distingue vértices pares e impares
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_id);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Grid_Vertex), vertices.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(Grid_Vertex), 0);
+
+        glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), 0);
+        glVertexAttribDivisor(1, 1);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_id);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+
+        glBindVertexArray(0);
     }
 
-    void Terrain::load_heightmap(const std::string& path)
+    void Terrain::upload_heightmap(const Heightfield& field, const std::vector<int8_t>& normals, const std::string& path)
     {
-        int w, h, c;
-        unsigned char* img = SOIL_load_image(path.c_str(), &w, &h, &c, SOIL_LOAD_L);
-        if (img) {
+        if (!field.empty()) {
             glGenTextures(1, &texture_id);
             glBindTexture(GL_TEXTURE_2D, texture_id);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, w, h, 0, GL_RED, GL_UNSIGNED_BYTE, img);
-            SOIL_free_image_data(img);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, field.get_width(), field.get_height(), 0, GL_RED, GL_UNSIGNED_BYTE, field.data());
+
+            glGenTextures(1, &normal_texture_id);
+            glBindTexture(GL_TEXTURE_2D, normal_texture_id);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8_SNORM, field.get_width(), field.get_height(), 0, GL_RG, GL_BYTE, normals.data());
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
         }
         else {
             std::cout << "Error loading heightmap: " << path << std::endl;
         }
     }
 
-    void Terrain::render(const Camera& camera)
+    Aabb Terrain::get_node_bounds(unsigned tree_depth, unsigned x, unsigned z) const
+    {
+        float     size   = 1.0f / float(1u << tree_depth);
+        glm::vec2 height = height_ranges[tree_depth][size_t(z) * (1u << tree_depth) + x];
+
+        Aabb bounds;
+        bounds.extend(glm::vec3( x      * size * width - width * 0.5f, height.x,  z      * size * depth - depth * 0.5f));
+        bounds.extend(glm::vec3((x + 1) * size * width - width * 0.5f, height.y, (z + 1) * size * depth - depth * 0.5f));
+
+        return bounds;
+    }
+
+    void Terrain::select(const Camera& camera, const Frustum& frustum, float viewport_height, float max_cell_pixels)
+    {
+        UDIT_TRACE_SCOPE("Terrain::select");
+
+        instances.clear();
+
+        if (height_ranges.empty()) return;
+
+        const glm::mat4& model = get_global_matrix();
+
+        camera_local = glm::vec3(glm::inverse(model) * camera.get_location());
+
+        // Lado de una celda de cada nivel en espacio local; la escala del nodo se cancela
+        // al proyectar, así que los rangos se calculan directamente en local
+        float cell = std::max(width, depth) / float((1u << (level_count - 1)) * PATCH_SIZE);
+
+        // Distancia a partir de la cual una celda ocupa un pixel
+        float pixels = viewport_height / (2.0f * std::tan(glm::radians(camera.get_fov()) * 0.5f));
+
+        // Rango de cada nivel: más allá, las celdas del nivel siguiente no superan
+        // max_cell_pixels. Nunca menos de dos nodos, para que los vecinos difieran a lo sumo
+        // en un nivel y la transición termine antes del cambio.
+        float ranges[MAX_LEVELS];
+        float previous = 0.0f;
+
+        for (unsigned level = 0; level < level_count; ++level)
+        {
+            float next_cell = cell * float(2u << level);
+
+            ranges[level] = next_cell * std::max(pixels / max_cell_pixels, float(PATCH_SIZE));
+
+            // El nivel más grueso no tiene siguiente: sin transición
+            if (level + 1 == level_count)
+            {
+                morph_ranges[level][0] = 1e30f;
+                morph_ranges[level][1] = 2e30f;
+            }
+            else
+            {
+                morph_ranges[level][0] = previous + (ranges[level] - previous) * MORPH_START;
+                morph_ranges[level][1] = ranges[level];
+            }
+
+            previous = ranges[level];
+        }
+
+        select_node(0, 0, 0, frustum, model, ranges);
+
+        upload_instances();
+    }
+
+    void Terrain::select_node(unsigned tree_depth, unsigned x, unsigned z, const Frustum& frustum, const glm::mat4& model, const float* ranges)
+    {
+        Aabb bounds = get_node_bounds(tree_depth, x, z);
+
+        if (!frustum.intersects(bounds.transformed(model))) return;
+
+        unsigned level = level_count - 1 - tree_depth;
+
+        // Sin parte dentro del rango del nivel inferior, el nodo se dibuja entero con el
+        // suyo; los hijos que quedan fuera de su rango se dibujan con la transición completa
+        // y coinciden con la rejilla de este nivel
+        if (level == 0 || distance_to(bounds, camera_local) > ranges[level - 1])
+        {
+            float size = 1.0f / float(1u << tree_depth);
+            instances.push_back({ glm::vec2(x * size, z * size), size, float(level) });
+            return;
+        }
+
+        for (unsigned child = 0; child < 4; ++child)
+        {
+            select_node(tree_depth + 1, 2 * x + (child & 1), 2 * z + (child >> 1), frustum, model, ranges);
+        }
+    }
+
+    void Terrain::upload_instances()
+    {
+        if (instances.empty()) return;
+
+        // Se reserva almacenamiento nuevo (orphaning) para no esperar a la GPU
+        glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+
+        if (instances.size() > instance_capacity) {
+            instance_capacity = std::max(instances.size(), instance_capacity * 2);
+        }
+
+        glBufferData   (GL_ARRAY_BUFFER, instance_capacity * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(Instance), instances.data());
+        glBindBuffer   (GL_ARRAY_BUFFER, 0);
+    }
+
+    Frame_Uniforms::Object Terrain::get_object_data() const
+    {
+        Frame_Uniforms::Object object;
+
+        object.model           = get_global_matrix();
+        object.normal_matrix   = glm::mat4(glm::transpose(glm::inverse(glm::mat3(object.model))));
+        object.parameters      = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+        object.position_scale  = glm::vec4(width, 1.0f, depth, 0.0f);
+        object.position_offset = glm::vec4(-width * 0.5f, 0.0f, -depth * 0.5f, 0.0f);
+
+        return object;
+    }
+
+    Terrain::Map_Transform Terrain::get_map_transform() const
+    {
+        // Con el eje Y vertical, la x y la z locales no dependen de la altura global
+        glm::mat4 inverse = glm::inverse(get_global_matrix());
+
+        Map_Transform map;
+
+        map.u_x = inverse[0][0] / width;
+        map.u_z = inverse[2][0] / width;
+        map.u_0 = inverse[3][0] / width + 0.5f;
+        map.v_x = inverse[0][2] / depth;
+        map.v_z = inverse[2][2] / depth;
+        map.v_0 = inverse[3][2] / depth + 0.5f;
+
+        return map;
+    }
+
+    float Terrain::height_at(float x, float z) const
+    {
+        Map_Transform map = get_map_transform();
+
+        float u = map.u_x * x + map.u_z * z + map.u_0;
+        float v = map.v_x * x + map.v_z * z + map.v_0;
+
+        glm::vec4 local(u * width - width * 0.5f, heightfield.sample(u, v) * max_height, v * depth - depth * 0.5f, 1.0f);
+
+        return (get_global_matrix() * local).y;
+    }
+
+    glm::vec3 Terrain::normal_at(float x, float z) const
+    {
+        Map_Transform map = get_map_transform();
+
+        float u = map.u_x * x + map.u_z * z + map.u_0;
+        float v = map.v_x * x + map.v_z * z + map.v_0;
+        float du, dv;
+
+        heightfield.gradient(u, v, du, dv);
+
+        // Pendientes locales: la altura es h * max_height y u recorre width
+        glm::vec3 local(-du * max_height / width, 1.0f, -dv * max_height / depth);
+
+        return glm::normalize(glm::transpose(glm::inverse(glm::mat3(get_global_matrix()))) * local);
+    }
+
+    void Terrain::heights_at(const float* x, const float* z, float* heights, size_t count) const
+    {
+        const size_t BLOCK = 256;
+
+        Map_Transform    map   = get_map_transform();
+        const glm::mat4& model = get_global_matrix();
+
+        // Coeficientes de la fila Y de la matriz en función de u, h y v
+        float y_u = model[0][1] * width;
+        float y_h = model[1][1] * max_height;
+        float y_v = model[2][1] * depth;
+        float y_0 = model[3][1] - (model[0][1] * width + model[2][1] * depth) * 0.5f;
+
+        float u[BLOCK], v[BLOCK];
+
+        for (size_t first = 0; first < count; first += BLOCK)
+        {
+            size_t block = std::min(BLOCK, count - first);
+
+            for (size_t i = 0; i < block; ++i)
+            {
+                u[i] = map.u_x * x[first + i] + map.u_z * z[first + i] + map.u_0;
+                v[i] = map.v_x * x[first + i] + map.v_z * z[first + i] + map.v_0;
+            }
+
+            float* h = heights + first;
+
+            heightfield.sample(u, v, h, block);
+
+            for (size_t i = 0; i < block; ++i)
+            {
+                h[i] = y_u * u[i] + y_h * h[i] + y_v * v[i] + y_0;
+            }
+        }
+    }
+
+    void Terrain::normals_at(const float* x, const float* z, glm::vec3* normals, size_t count) const
     {
-        if (shader_program_id == 0) return;
+        const size_t BLOCK = 256;
+
+        Map_Transform map           = get_map_transform();
+        glm::mat3     normal_matrix = glm::transpose(glm::inverse(glm::mat3(get_global_matrix())));
+
+        float slope_u = max_height / width;
+        float slope_v = max_height / depth;
+
+        float u[BLOCK], v[BLOCK], du[BLOCK], dv[BLOCK];
+
+        for (size_t first = 0; first < count; first += BLOCK)
+        {
+            size_t block = std::min(BLOCK, count - first);
+
+            for (size_t i = 0; i < block; ++i)
+            {
+                u[i] = map.u_x * x[first + i] + map.u_z * z[first + i] + map.u_0;
+                v[i] = map.v_x * x[first + i] + map.v_z * z[first + i] + map.v_0;
+            }
+
+            heightfield.gradient(u, v, du, dv, block);
+
+            for (size_t i = 0; i < block; ++i)
+            {
+                normals[first + i] = glm::normalize(normal_matrix * glm::vec3(-du[i] * slope_u, 1.0f, -dv[i] * slope_v));
+            }
+        }
+    }
 
-        glUseProgram(shader_program_id);
+    void Terrain::draw_patches(GLuint program_id, const Program_Locations& program_locations) const
+    {
+        if (program_id == 0 || texture_id == 0 || instances.empty()) return;
 
-        glUniformMatrix4fv(proj_loc, 1, GL_FALSE, glm::value_ptr(camera.get_projection_matrix()));
-        glUniformMatrix4fv(view_loc, 1, GL_FALSE, glm::value_ptr(camera.get_transform_matrix_inverse()));
-        glUniformMatrix4fv(model_loc, 1, GL_FALSE, glm::value_ptr(get_global_matrix()));
+        glUseProgram(program_id);
 
-        glUniform1f(max_height_loc, 8.0f); 
+        // Cámara y niebla llegan en el bloque Frame; la matriz model, en el rango del terreno
+        Frame_Uniforms::bind_object(object_slot);
 
-        
-        glUniform3f(fog_color_loc, 0.5f, 0.5f, 0.5f);
-        glUniform1f(fog_density_loc, 0.04f);
+        glUniform1f (program_locations.max_height, max_height);
+        glUniform3fv(program_locations.camera, 1, glm::value_ptr(camera_local));
+        glUniform2fv(program_locations.morph_ranges, GLsizei(level_count), &morph_ranges[0][0]);
 
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, texture_id);
-        glUniform1i(texture_loc, 0);
+        glUniform1i(program_locations.height_map, 0);
 
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, normal_texture_id);
+        glUniform1i(program_locations.normal_map, 1);
+        glActiveTexture(GL_TEXTURE0);
+
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(0xFFFF);
+
+        // Todos los nodos elegidos en una sola llamada
         glBindVertexArray(vao_id);
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, number_of_vertices);
+        glDrawElementsInstanced(GL_TRIANGLE_STRIP, patch_index_count, GL_UNSIGNED_SHORT, nullptr, GLsizei(instances.size()));
         glBindVertexArray(0);
 
+        glDisable(GL_PRIMITIVE_RESTART);
+    }
+
+    void Terrain::render(const Camera& camera)
+    {
+        UDIT_TRACE_SCOPE("Terrain::render");
+
+        draw_patches(shader_program_id, locations);
+
         Node::render(camera);
     }
 
+    void Terrain::render_depth()
+    {
+        UDIT_TRACE_SCOPE("Terrain::render_depth");
+
+        draw_patches(depth_program_id, depth_locations);
+    }
+
+    GLuint Terrain::link_program(const std::string& vertex_code, const char* fragment_code, Program_Locations& program_locations)
+    {
+        const char* vCode = vertex_code.c_str();
+
+        GLuint v = glCreateShader(GL_VERTEX_SHADER); glShaderSource(v, 1, &vCode, NULL); glCompileShader(v);
+        GLuint f = glCreateShader(GL_FRAGMENT_SHADER); glShaderSource(f, 1, &fragment_code, NULL); glCompileShader(f);
+        GLuint program_id = glCreateProgram();
+        glAttachShader(program_id, v); glAttachShader(program_id, f); glLinkProgram(program_id);
+        glDeleteShader(v); glDeleteShader(f);
+
+        Frame_Uniforms::bind_blocks(program_id);
+
+        program_locations.max_height   = glGetUniformLocation(program_id, "max_height");
+        program_locations.height_map   = glGetUniformLocation(program_id, "heightMap");
+        program_locations.normal_map   = glGetUniformLocation(program_id, "normalMap");
+        program_locations.camera       = glGetUniformLocation(program_id, "camera_local");
+        program_locations.morph_ranges = glGetUniformLocation(program_id, "morph_ranges");
+
+        return program_id;
+    }
+
     void Terrain::compile_shaders()
     {
-        
-        const char* vSource = R"(
-            #version 330 core
-            layout (location = 0) in vec2 aPos;
-            layout (location = 1) in vec2 aTex;
 
+        std::string vSource = std::string("#version 330 core\n") + Frame_Uniforms::FRAME_BLOCK + Frame_Uniforms::OBJECT_BLOCK + TERRAIN_POSITION + R"(
             out vec3 FragPos;
             out float Height;
             out vec3 Normal;
 
-            uniform mat4 model;
-            uniform mat4 view;
-            uniform mat4 projection;
-            uniform sampler2D heightMap;
-            uniform float max_height;
+            uniform sampler2D normalMap;
+
+            // Misma posición exacta que en el pre-pase de profundidad
+            invariant gl_Position;
 
             void main() {
-                float h = texture(heightMap, aTex).r;
+                vec2 uv;
+                float h;
+                vec4 worldPos = terrain_position(uv, h);
                 Height = h;
 
-                // Suavizado de normales
-                float off = 1.0 / 256.0; 
-                float hL = texture(heightMap, aTex + vec2(-off, 0)).r;
-                float hR = texture(heightMap, aTex + vec2( off, 0)).r;
-                float hD = texture(heightMap, aTex + vec2(0, -off)).r;
-                float hU = texture(heightMap, aTex + vec2(0,  off)).r;
-                Normal = normalize(vec3(hL - hR, 2.0 / max_height, hD - hU));
+                // Normal local precalculada (Sobel al cargar); la y siempre es positiva
+                vec2 n = texture(normalMap, uv).rg;
+                Normal = normalize(mat3(normal_matrix) * vec3(n.x, sqrt(max(1.0 - dot(n, n), 0.0)), n.y));
 
-                vec3 pos3D = vec3(aPos.x, h * max_height, aPos.y);
-                vec4 worldPos = model * vec4(pos3D, 1.0);
                 FragPos = worldPos.xyz;
-                
-                gl_Position = projection * view * worldPos;
+
+                gl_Position = view_projection * worldPos;
             }
         )";
 
-        
-        const char* fSource = R"(
-            #version 330 core
+
+        std::string fSource = std::string("#version 330 core\n") + Frame_Uniforms::FRAME_BLOCK + R"(
             out vec4 FragColor;
-            
+
             in vec3 FragPos;
             in float Height;
             in vec3 Normal;
 
-            uniform vec3 fog_color;
-            uniform float fog_density;
-
             void main() {
                 vec3 norm = normalize(Normal);
                 vec3 sunDir = normalize(vec3(0.3, 1.0, 0.5));
                 float diff = max(dot(norm, sunDir), 0.25);
 
-                //  colores matematicos (Sin texturas externas) 
-                // Interpolacin entre color roca y color nieve segn altura (Height)
+                //  colores matematicos (Sin texturas externas)
+                // Interpolación entre color roca y color nieve según altura (Height)
                 vec3 rockColor = vec3(0.2, 0.2, 0.2); // Gris oscuro
                 vec3 snowColor = vec3(0.9, 0.9, 0.9); // Blanco
 
-                
+
                 vec3 objectColor = mix(rockColor, snowColor, Height);
 
                 vec3 litColor = objectColor * diff;
 
                 // Niebla Exponencial basada en profundidad
-                float fogFactor = 1.0 / exp(pow(gl_FragCoord.z / gl_FragCoord.w * fog_density, 2.0));
+                float fogFactor = 1.0 / exp(pow(gl_FragCoord.z / gl_FragCoord.w * fog.a, 2.0));
                 fogFactor = clamp(fogFactor, 0.0, 1.0);
 
-                FragColor = vec4(mix(fog_color, litColor, fogFactor), 1.0);
+                FragColor = vec4(mix(fog.rgb, litColor, fogFactor), 1.0);
             }
         )";
 
-        GLuint v = glCreateShader(GL_VERTEX_SHADER); glShaderSource(v, 1, &vSource, NULL); glCompileShader(v);
-        GLuint f = glCreateShader(GL_FRAGMENT_SHADER); glShaderSource(f, 1, &fSource, NULL); glCompileShader(f);
-        shader_program_id = glCreateProgram();
-        glAttachShader(shader_program_id, v); glAttachShader(shader_program_id, f); glLinkProgram(shader_program_id);
-        glDeleteShader(v); glDeleteShader(f);
+        shader_program_id = link_program(vSource, fSource.c_str(), locations);
+
+        // Pre-pase de profundidad: solo la altura del mapa, sin normales ni color
+        std::string vDepthSource = std::string("#version 330 core\n") + Frame_Uniforms::FRAME_BLOCK + Frame_Uniforms::OBJECT_BLOCK + TERRAIN_POSITION + R"(
+            invariant gl_Position;
+
+            void main() {
+                vec2 uv;
+                float h;
+                gl_Position = view_projection * terrain_position(uv, h);
+            }
+        )";
+
+        const char* fDepthCode = R"(
+            #version 330 core
+            void main() {}
+        )";
 
-        model_loc = glGetUniformLocation(shader_program_id, "model");
-        view_loc = glGetUniformLocation(shader_program_id, "view");
-        proj_loc = glGetUniformLocation(shader_program_id, "projection");
-        max_height_loc = glGetUniformLocation(shader_program_id, "max_height");
-        texture_loc = glGetUniformLocation(shader_program_id, "heightMap");
-        fog_color_loc = glGetUniformLocation(shader_program_id, "fog_color");
-        fog_density_loc = glGetUniformLocation(shader_program_id, "fog_density");
+        depth_program_id = link_program(vDepthSource, fDepthCode, depth_locations);
     }
-}
\ No newline at end of file
+}
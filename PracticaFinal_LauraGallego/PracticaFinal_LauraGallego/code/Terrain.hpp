@@ -1,9 +1,12 @@
-// Este cdigo es de dominio pblico
+// Este código es de dominio público
 // penterrin@gmail.com
 
 #pragma once
 
 #include "Node.hpp"
+#include "Frame_Uniforms.hpp"
+#include "Heightfield.hpp"
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <glad/gl.h>
@@ -11,31 +14,141 @@
 
 namespace udit
 {
+    class Camera;
+    class Frustum;
+
+    // Terreno con nivel de detalle continuo (CDLOD, Strugar 2009). Un único parche de
+    // PATCH_SIZE x PATCH_SIZE celdas se dibuja instanciado sobre los nodos de un quadtree
+    // que cubre el mapa de alturas; cada nodo elegido lleva su posición, su tamaño y su
+    // nivel. Los vértices se deslizan hacia la rejilla del nivel siguiente según la
+    // distancia a la cámara, así que los cambios de nivel no saltan ni abren grietas.
     class Terrain : public Node
     {
+    public:
+
+        static const unsigned PATCH_SIZE = 32;          // Celdas por lado del parche
+        static const unsigned MAX_LEVELS = 16;
+
     private:
+
+        // Vértice del parche: coordenada entera de rejilla en [0, PATCH_SIZE]; la altura
+        // se lee del mapa en el vertex shader
+        struct Grid_Vertex
+        {
+            uint16_t x, z;
+        };
+
+        // Nodo elegido para este frame (atributo por instancia)
+        struct Instance
+        {
+            glm::vec2 origin;           // Esquina en coordenadas del mapa [0, 1]
+            float     size;             // Lado en coordenadas del mapa
+            float     level;            // 0 = el más fino
+        };
+
+        struct Program_Locations
+        {
+            GLint max_height, height_map, normal_map, camera, morph_ranges;
+        };
+
         GLuint vao_id;
-        GLuint vbo_ids[2]; 
-        GLuint texture_id; 
+        GLuint vbo_id;
+        GLuint ebo_id;
+        GLuint instance_buffer;
+        GLuint texture_id;
+        GLuint normal_texture_id;       // Normales locales (x, z) precalculadas al cargar
         GLuint shader_program_id;
+        GLuint depth_program_id;        // Solo profundidad, para el pre-pase
+
+        GLsizei patch_index_count;      // Una tira por fila separada por 0xFFFF
+
+        Program_Locations locations, depth_locations;
+
+        // Alturas mínima y máxima (locales) de cada nodo, por profundidad del quadtree y
+        // en filas de 2^profundidad nodos; la última profundidad son las hojas
+        std::vector< std::vector<glm::vec2> > height_ranges;
+
+        Heightfield heightfield;        // Copia del mapa para consultas desde la CPU
+
+        unsigned level_count;           // Profundidades del quadtree (nivel 0 = hojas)
+
+        float     morph_ranges[MAX_LEVELS][2];          // Inicio y fin de la transición de cada nivel
+        glm::vec3 camera_local;                         // Cámara en espacio del terreno
+
+        std::vector<Instance> instances;                // Nodos elegidos en el último select()
+        size_t                instance_capacity;
 
-        GLsizei number_of_vertices;
+        Frame_Uniforms::Object_Slot object_slot;
 
-        
-        GLint model_loc, view_loc, proj_loc;
-        GLint max_height_loc, texture_loc;
-        GLint fog_color_loc, fog_density_loc;
+        float    width;
+        float    depth;
+        float    max_height;
+        Aabb     local_bounds;          // Rejilla completa con el rango de alturas posible
 
     public:
-        
+
+        // x_slices y z_slices fijan la resolución del nivel más fino (se redondean a una
+        // potencia de dos de parches)
         Terrain(float width, float depth, unsigned x_slices, unsigned z_slices, const std::string& texture_path);
         ~Terrain();
 
-        
+
+        // Bloque Object del terreno para el frame actual y el rango donde se subió
+        Frame_Uniforms::Object get_object_data() const;
+        void                   set_object_slot(const Frame_Uniforms::Object_Slot& slot) { object_slot = slot; }
+
         virtual void render(const Camera& camera) override;
 
+        // Solo escribe profundidad, con la misma posición que render()
+        void render_depth();
+
+        virtual bool get_local_bounds(Aabb& bounds) const override { bounds = local_bounds; return true; }
+
+        Aabb get_world_bounds() const { return local_bounds.transformed(get_global_matrix()); }
+
+        // Recorre el quadtree descartando por la pirámide de visión y elige los nodos de
+        // forma que una celda no ocupe más de max_cell_pixels en pantalla. render() y
+        // render_depth() dibujan todos los elegidos con un único glDrawElementsInstanced.
+        void select(const Camera& camera, const Frustum& frustum, float viewport_height, float max_cell_pixels);
+
+        size_t get_patch_count   () const { return instances.size(); }
+        size_t get_triangle_count() const { return instances.size() * PATCH_SIZE * PATCH_SIZE * 2; }
+
+        // Consultas en espacio global sobre la copia del mapa en la CPU, con el mismo
+        // filtrado que la GPU (sin el morphing del LOD, que solo desplaza los vértices
+        // dentro de la superficie del nivel fino). x y z se proyectan verticalmente sobre
+        // el terreno, así que la transformación del nodo debe mantener el eje Y vertical
+        // (traslación, giro en Y y escala). Fuera del mapa se repite el borde. Hasta que
+        // termina la carga la altura es la del plano base.
+        bool      has_heightfield() const { return !heightfield.empty(); }
+        float     height_at      (float x, float z) const;
+        glm::vec3 normal_at      (float x, float z) const;
+
+        // Variantes por lotes (estructura de arrays) para muchas consultas por frame
+        void heights_at(const float* x, const float* z, float* heights, size_t count) const;
+        void normals_at(const float* x, const float* z, glm::vec3* normals, size_t count) const;
+
     private:
         void compile_shaders();
-        void load_heightmap(const std::string& path);
+        GLuint link_program(const std::string& vertex_code, const char* fragment_code, Program_Locations& program_locations);
+
+        static void build_height_ranges(std::vector< std::vector<glm::vec2> >& ranges, unsigned level_count, const unsigned char* pixels, int image_width, int image_height, float max_height);
+
+        Aabb get_node_bounds(unsigned tree_depth, unsigned x, unsigned z) const;
+        void select_node    (unsigned tree_depth, unsigned x, unsigned z, const Frustum& frustum, const glm::mat4& model, const float* ranges);
+
+        void upload_patch();
+        void upload_instances();
+        void draw_patches(GLuint program_id, const Program_Locations& program_locations) const;
+        void upload_heightmap(const Heightfield& field, const std::vector<int8_t>& normals, const std::string& path);
+
+        // Paso de coordenadas globales (x, z) a coordenadas del mapa [0, 1]
+        struct Map_Transform
+        {
+            float u_x, u_z, u_0;
+            float v_x, v_z, v_0;
+        };
+
+        Map_Transform get_map_transform() const;
     };
-}
\ No newline at end of file
+}
@@ -1,27 +1,53 @@
 
-// Este cdigo es de dominio pblico
+// Este código es de dominio público
 // angel.rodriguez@udit.es
 
+#include <algorithm>
 #include <vector>
 #include <SOIL2.h>
 #include "Texture_Cube.hpp"
+#include "Asset_Loader.hpp"
+#include "Trace.hpp"
 
 namespace udit
 {
 
     Texture_Cube::Texture_Cube(const std::string & texture_base_path)
     {
+        UDIT_TRACE_SCOPE("Texture_Cube::Texture_Cube");
+
+        texture_id        = 0;
         texture_is_loaded = false;
 
-        // Se intentan cargar los mapas de bits de todas las caras:
+        // Cada cara se decodifica en un hilo de trabajo; la textura se crea en el hilo de
+        // OpenGL cuando han llegado las seis (si falta alguna, no se crea):
 
-        std::vector< std::shared_ptr< Color_Buffer > > texture_sides(6);
+        auto texture_sides = std::make_shared< std::vector< std::shared_ptr< Color_Buffer > > > (6);
+        auto arrived       = std::make_shared< size_t > (0);
 
         for (size_t texture_index = 0; texture_index < 6; texture_index++)
         {
-            texture_sides[texture_index] = load_image (texture_base_path + char('0' + texture_index) + ".png");
+            std::string image_path = texture_base_path + char('0' + texture_index) + ".png";
+
+            Asset_Loader::instance ().submit ([this, texture_sides, arrived, texture_index, image_path] () -> Asset_Loader::Upload
+            {
+                std::shared_ptr< Color_Buffer > image = load_image (image_path);
 
-            if (!texture_sides[texture_index])
+                return [this, texture_sides, arrived, texture_index, image]
+                {
+                    (*texture_sides)[texture_index] = image;
+
+                    if (++*arrived == 6) upload (*texture_sides);
+                };
+            });
+        }
+    }
+
+    void Texture_Cube::upload (const std::vector< std::shared_ptr< Color_Buffer > > & texture_sides)
+    {
+        for (auto & side : texture_sides)
+        {
+            if (!side)
             {
                 return;
             }
@@ -44,7 +70,7 @@ namespace udit
         glTexParameteri (GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T,     GL_CLAMP_TO_EDGE);
         glTexParameteri (GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R,     GL_CLAMP_TO_EDGE);
 
-        // Se envan los mapas de bits a la GPU:
+        // Se envían los mapas de bits a la GPU:
 
         static const GLenum texture_target[] =
         {
@@ -110,7 +136,7 @@ namespace udit
                 reinterpret_cast< uint8_t * >(image->colors ())
             );
 
-            // Se libera la memoria que reserv SOIL2 para cargar la imagen:
+            // Se libera la memoria que reservó SOIL2 para cargar la imagen:
 
             SOIL_free_image_data (loaded_pixels);
 
@@ -1,5 +1,5 @@
 
-// Este cdigo es de dominio pblico
+// Este código es de dominio público
 // penterrin@gmail.com
 
 #ifndef TEXTURE_CUBE_HEADER
@@ -7,6 +7,7 @@
 
     #include <memory>
     #include <string>
+    #include <vector>
     #include <glad/gl.h>
     #include <Color.hpp>
     #include <Color_Buffer.hpp>
@@ -27,6 +28,7 @@
 
         public:
 
+            // Las caras se cargan de forma asíncrona (Asset_Loader); is_ok() indica si ya está lista
             Texture_Cube(const std::string & texture_base_path);
            ~Texture_Cube();
 
@@ -38,6 +40,7 @@
         private:
 
             std::shared_ptr< Color_Buffer > load_image (const std::string & image_path);
+            void                            upload     (const std::vector< std::shared_ptr< Color_Buffer > > & texture_sides);
 
         public:
 
@@ -0,0 +1,119 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#include "Thread_Pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace udit
+{
+    Thread_Pool::Thread_Pool(unsigned thread_count) : stopping(false)
+    {
+        if (thread_count == 0)
+        {
+            unsigned cores = std::thread::hardware_concurrency();
+            thread_count = cores > 1 ? cores - 1 : 1;
+        }
+
+        for (unsigned i = 0; i < thread_count; ++i)
+        {
+            workers.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    Thread_Pool::~Thread_Pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        condition.notify_all();
+
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    Thread_Pool& Thread_Pool::instance()
+    {
+        static Thread_Pool pool;
+        return pool;
+    }
+
+    void Thread_Pool::submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+
+        condition.notify_one();
+    }
+
+    void Thread_Pool::parallel_for(size_t count, const std::function<void(size_t)>& body)
+    {
+        if (count == 0) return;
+
+        // Estado compartido: los ayudantes que arranquen tarde (detrás de otras tareas)
+        // solo consultan el contador y salen sin tocar body
+        struct State
+        {
+            std::atomic<size_t>                  next{ 0 };
+            std::atomic<size_t>                  completed{ 0 };
+            size_t                               count;
+            const std::function<void(size_t)>*   body;
+            std::mutex                           mutex;
+            std::condition_variable              done;
+        };
+
+        auto state = std::make_shared<State>();
+        state->count = count;
+        state->body  = &body;
+
+        auto run = [] (State& s)
+        {
+            for (size_t i; (i = s.next.fetch_add(1)) < s.count; )
+            {
+                (*s.body)(i);
+
+                if (s.completed.fetch_add(1) + 1 == s.count)
+                {
+                    std::lock_guard<std::mutex> lock(s.mutex);
+                    s.done.notify_all();
+                }
+            }
+        };
+
+        size_t helpers = std::min<size_t>(workers.size(), count - 1);
+
+        for (size_t h = 0; h < helpers; ++h)
+        {
+            submit([state, run] { run(*state); });
+        }
+
+        run(*state);
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->done.wait(lock, [&state] { return state->completed.load() == state->count; });
+    }
+
+    void Thread_Pool::worker_loop()
+    {
+        for (;;)
+        {
+            std::function<void()> task;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+
+                if (stopping && tasks.empty()) return;
+
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+
+            task();
+        }
+    }
+}
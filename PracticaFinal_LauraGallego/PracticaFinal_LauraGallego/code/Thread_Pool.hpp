@@ -0,0 +1,51 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace udit
+{
+    // Conjunto de hilos de trabajo compartido por el motor
+    class Thread_Pool
+    {
+    private:
+
+        std::vector<std::thread>          workers;
+        std::deque<std::function<void()>> tasks;
+        std::mutex                        mutex;
+        std::condition_variable           condition;
+        bool                              stopping;
+
+    public:
+
+        // 0 hilos = uno menos que los núcleos disponibles (el hilo principal también trabaja)
+        explicit Thread_Pool(unsigned thread_count = 0);
+       ~Thread_Pool();
+
+        Thread_Pool(const Thread_Pool&) = delete;
+        Thread_Pool& operator=(const Thread_Pool&) = delete;
+
+        static Thread_Pool& instance();
+
+        unsigned get_worker_count() const { return unsigned(workers.size()); }
+
+        // Encola una tarea sin esperar a que termine
+        void submit(std::function<void()> task);
+
+        // Ejecuta body(i) para i en [0, count) y espera a que terminen todos.
+        // El hilo que llama también ejecuta iteraciones.
+        void parallel_for(size_t count, const std::function<void(size_t)>& body);
+
+    private:
+
+        void worker_loop();
+    };
+}
@@ -0,0 +1,144 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#include "Trace.hpp"
+
+#ifdef UDIT_TRACE_ENABLED
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace udit
+{
+    namespace trace
+    {
+        namespace
+        {
+            struct Event
+            {
+                const char* name;
+                double      start_us;
+                double      duration_us;
+            };
+
+            // Bloque de eventos de un único hilo. Solo escribe su dueño; el contador
+            // se publica con release para que flush() lea eventos completos.
+            struct Chunk
+            {
+                static constexpr size_t capacity = 16384;
+
+                Event                events[capacity];
+                std::atomic<size_t>  count{ 0 };
+                std::atomic<Chunk*>  next { nullptr };
+            };
+
+            struct Thread_Buffer
+            {
+                unsigned                            thread_id;
+                Chunk*                              tail;
+                std::vector<std::unique_ptr<Chunk>> chunks;         // Solo lo toca su hilo al crecer
+                Chunk*                              head;
+            };
+
+            // Registro global de buffers. El mutex solo se toma la primera vez que un hilo
+            // traza y al volcar; los buffers sobreviven a sus hilos.
+            std::mutex                                  registry_mutex;
+            std::vector<std::unique_ptr<Thread_Buffer>> registry;
+
+            const Clock::time_point epoch = Clock::now();
+
+            Thread_Buffer* create_buffer()
+            {
+                auto buffer = std::make_unique<Thread_Buffer>();
+
+                buffer->chunks.push_back(std::make_unique<Chunk>());
+                buffer->head = buffer->tail = buffer->chunks.back().get();
+
+                std::lock_guard<std::mutex> lock(registry_mutex);
+
+                buffer->thread_id = unsigned(registry.size()) + 1;
+                registry.push_back(std::move(buffer));
+
+                return registry.back().get();
+            }
+
+            Thread_Buffer& local_buffer()
+            {
+                thread_local Thread_Buffer* buffer = create_buffer();
+                return *buffer;
+            }
+
+            double to_microseconds(Clock::duration duration)
+            {
+                return std::chrono::duration<double, std::micro>(duration).count();
+            }
+        }
+
+        void record(const char* name, Clock::time_point start, Clock::time_point end)
+        {
+            Thread_Buffer& buffer = local_buffer();
+            Chunk* chunk = buffer.tail;
+
+            size_t index = chunk->count.load(std::memory_order_relaxed);
+
+            if (index == Chunk::capacity)
+            {
+                auto new_chunk = std::make_unique<Chunk>();
+                Chunk* next = new_chunk.get();
+
+                buffer.chunks.push_back(std::move(new_chunk));
+                chunk->next.store(next, std::memory_order_release);
+                buffer.tail = chunk = next;
+                index = 0;
+            }
+
+            chunk->events[index] = Event{ name, to_microseconds(start - epoch), to_microseconds(end - start) };
+            chunk->count.store(index + 1, std::memory_order_release);
+        }
+
+        bool flush(const std::string& path)
+        {
+            std::ofstream file(path);
+
+            if (!file.is_open()) return false;
+
+            file << std::fixed << std::setprecision(3);
+            file << "{\"traceEvents\":[\n";
+
+            bool first = true;
+
+            std::lock_guard<std::mutex> lock(registry_mutex);
+
+            for (const auto& buffer : registry)
+            {
+                for (Chunk* chunk = buffer->head; chunk; chunk = chunk->next.load(std::memory_order_acquire))
+                {
+                    size_t count = chunk->count.load(std::memory_order_acquire);
+
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        const Event& event = chunk->events[i];
+
+                        file << (first ? "" : ",\n")
+                             << "{\"name\":\"" << event.name << "\",\"cat\":\"cpu\",\"ph\":\"X\""
+                             << ",\"ts\":"  << event.start_us
+                             << ",\"dur\":" << event.duration_us
+                             << ",\"pid\":1,\"tid\":" << buffer->thread_id << "}";
+
+                        first = false;
+                    }
+                }
+            }
+
+            file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+            return true;
+        }
+    }
+}
+
+#endif
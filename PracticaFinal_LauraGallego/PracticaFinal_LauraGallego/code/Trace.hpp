@@ -0,0 +1,55 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+// Trazas de CPU por ámbito exportables a chrome://tracing / Perfetto.
+//
+// Solo se compilan si se define UDIT_TRACE_ENABLED (activo en Debug). Sin él,
+// UDIT_TRACE_SCOPE y UDIT_TRACE_FLUSH no generan código.
+
+#ifdef UDIT_TRACE_ENABLED
+
+    #include <chrono>
+    #include <string>
+
+    namespace udit
+    {
+        namespace trace
+        {
+            using Clock = std::chrono::steady_clock;
+
+            // Registra un evento completo en el buffer del hilo actual (sin bloqueos)
+            void record(const char* name, Clock::time_point start, Clock::time_point end);
+
+            // Escribe todos los eventos registrados hasta ahora en formato Trace Event JSON
+            bool flush(const std::string& path);
+
+            class Scope
+            {
+                const char*       name;
+                Clock::time_point start;
+
+            public:
+
+                explicit Scope(const char* name) : name(name), start(Clock::now()) {}
+               ~Scope() { record(name, start, Clock::now()); }
+
+                Scope(const Scope&) = delete;
+                Scope& operator=(const Scope&) = delete;
+            };
+        }
+    }
+
+    #define UDIT_TRACE_CONCAT_(a, b) a##b
+    #define UDIT_TRACE_CONCAT(a, b)  UDIT_TRACE_CONCAT_(a, b)
+
+    #define UDIT_TRACE_SCOPE(name)   udit::trace::Scope UDIT_TRACE_CONCAT(trace_scope_, __LINE__)(name)
+    #define UDIT_TRACE_FLUSH(path)   udit::trace::flush(path)
+
+#else
+
+    #define UDIT_TRACE_SCOPE(name)   ((void)0)
+    #define UDIT_TRACE_FLUSH(path)   ((void)0)
+
+#endif
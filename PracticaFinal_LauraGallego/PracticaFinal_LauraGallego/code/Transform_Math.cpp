@@ -0,0 +1,267 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#include "Transform_Math.hpp"
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+    #define UDIT_X86 1
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+        #define UDIT_TARGET_AVX2
+    #else
+        #define UDIT_TARGET_AVX2 __attribute__((target("avx2,fma")))
+    #endif
+#endif
+
+namespace udit
+{
+    namespace transform_math
+    {
+        namespace
+        {
+            // glm::mat4 guarda 16 floats contiguos por columnas
+            inline const float* data(const glm::mat4& m) { return &m[0][0]; }
+            inline float*       data(glm::mat4& m)       { return &m[0][0]; }
+
+            // ---- Escalar --------------------------------------------------------------------------------
+
+            void multiply_scalar(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+            {
+                glm::mat4 result;
+
+                for (int j = 0; j < 4; ++j)
+                {
+                    result[j] = a[0] * b[j].x + a[1] * b[j].y + a[2] * b[j].z + a[3] * b[j].w;
+                }
+
+                out = result;
+            }
+
+            void multiply_batch_scalar(const glm::mat4* const* parents, const glm::mat4* locals, glm::mat4* out, size_t count)
+            {
+                for (size_t i = 0; i < count; ++i) multiply_scalar(*parents[i], locals[i], out[i]);
+            }
+
+            #ifdef UDIT_X86
+
+            // ---- SSE: una columna de salida por operación -----------------------------------------------
+
+            inline void multiply_sse(const float* a, const float* b, float* out)
+            {
+                __m128 a0 = _mm_loadu_ps(a +  0);
+                __m128 a1 = _mm_loadu_ps(a +  4);
+                __m128 a2 = _mm_loadu_ps(a +  8);
+                __m128 a3 = _mm_loadu_ps(a + 12);
+
+                __m128 r[4];
+
+                for (int j = 0; j < 4; ++j)
+                {
+                    __m128 column = _mm_loadu_ps(b + j * 4);
+
+                    __m128 x = _mm_shuffle_ps(column, column, _MM_SHUFFLE(0, 0, 0, 0));
+                    __m128 y = _mm_shuffle_ps(column, column, _MM_SHUFFLE(1, 1, 1, 1));
+                    __m128 z = _mm_shuffle_ps(column, column, _MM_SHUFFLE(2, 2, 2, 2));
+                    __m128 w = _mm_shuffle_ps(column, column, _MM_SHUFFLE(3, 3, 3, 3));
+
+                    r[j] = _mm_add_ps
+                    (
+                        _mm_add_ps(_mm_mul_ps(a0, x), _mm_mul_ps(a1, y)),
+                        _mm_add_ps(_mm_mul_ps(a2, z), _mm_mul_ps(a3, w))
+                    );
+                }
+
+                // Se escribe al final para admitir out == b
+                for (int j = 0; j < 4; ++j) _mm_storeu_ps(out + j * 4, r[j]);
+            }
+
+            void multiply_batch_sse(const glm::mat4* const* parents, const glm::mat4* locals, glm::mat4* out, size_t count)
+            {
+                for (size_t i = 0; i < count; ++i) multiply_sse(data(*parents[i]), data(locals[i]), data(out[i]));
+            }
+
+            // ---- AVX2 + FMA: dos columnas de salida por operación --------------------------------------
+
+            UDIT_TARGET_AVX2 inline void multiply_avx2(const float* a, const float* b, float* out)
+            {
+                // Cada columna de a se repite en las dos mitades del registro de 256 bits
+                __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a +  0));
+                __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a +  4));
+                __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a +  8));
+                __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 12));
+
+                __m256 b01 = _mm256_loadu_ps(b + 0);
+                __m256 b23 = _mm256_loadu_ps(b + 8);
+
+                __m256 r01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+                r01 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b01, 0x55), r01);
+                r01 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b01, 0xAA), r01);
+                r01 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b01, 0xFF), r01);
+
+                __m256 r23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+                r23 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b23, 0x55), r23);
+                r23 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b23, 0xAA), r23);
+                r23 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b23, 0xFF), r23);
+
+                _mm256_storeu_ps(out + 0, r01);
+                _mm256_storeu_ps(out + 8, r23);
+            }
+
+            UDIT_TARGET_AVX2 void multiply_batch_avx2(const glm::mat4* const* parents, const glm::mat4* locals, glm::mat4* out, size_t count)
+            {
+                size_t i = 0;
+
+                // Lotes de 4 matrices desenrollados para solapar las cargas con las FMA
+                for (; i + 4 <= count; i += 4)
+                {
+                    multiply_avx2(data(*parents[i + 0]), data(locals[i + 0]), data(out[i + 0]));
+                    multiply_avx2(data(*parents[i + 1]), data(locals[i + 1]), data(out[i + 1]));
+                    multiply_avx2(data(*parents[i + 2]), data(locals[i + 2]), data(out[i + 2]));
+                    multiply_avx2(data(*parents[i + 3]), data(locals[i + 3]), data(out[i + 3]));
+                }
+
+                for (; i < count; ++i) multiply_avx2(data(*parents[i]), data(locals[i]), data(out[i]));
+            }
+
+            bool cpu_supports_avx2()
+            {
+                #ifdef _MSC_VER
+                    int info[4];
+                    __cpuid(info, 0);
+                    if (info[0] < 7) return false;
+
+                    __cpuid(info, 1);
+                    bool fma     = (info[2] & (1 << 12)) != 0;
+                    bool osxsave = (info[2] & (1 << 27)) != 0;
+                    if (!fma || !osxsave) return false;
+
+                    // El sistema operativo debe guardar los registros YMM
+                    if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+                    __cpuidex(info, 7, 0);
+                    return (info[1] & (1 << 5)) != 0;
+                #else
+                    __builtin_cpu_init();
+                    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+                #endif
+            }
+
+            #endif
+
+            // ---- Selección del núcleo -------------------------------------------------------------------
+
+            using Multiply_Batch = void (*)(const glm::mat4* const*, const glm::mat4*, glm::mat4*, size_t);
+
+            struct Kernels
+            {
+                Instruction_Set best;
+                Instruction_Set active;
+                Multiply_Batch  multiply_batch;
+            };
+
+            void select(Kernels& kernels, Instruction_Set set)
+            {
+                if (set > kernels.best) set = kernels.best;
+
+                kernels.active = set;
+
+                switch (set)
+                {
+                    #ifdef UDIT_X86
+                    case Instruction_Set::AVX2: kernels.multiply_batch = multiply_batch_avx2; break;
+                    case Instruction_Set::SSE:  kernels.multiply_batch = multiply_batch_sse;  break;
+                    #endif
+                    default:                    kernels.multiply_batch = multiply_batch_scalar; break;
+                }
+            }
+
+            Kernels& kernels()
+            {
+                static Kernels instance = []
+                {
+                    Kernels k{ Instruction_Set::SCALAR, Instruction_Set::SCALAR, multiply_batch_scalar };
+
+                    #ifdef UDIT_X86
+                        k.best = cpu_supports_avx2() ? Instruction_Set::AVX2 : Instruction_Set::SSE;
+                    #endif
+
+                    select(k, k.best);
+                    return k;
+                }();
+
+                return instance;
+            }
+
+            // Columnas de rotación escaladas + traslación
+            inline void store_trs(const glm::vec3& c0, const glm::vec3& c1, const glm::vec3& c2, const glm::vec3& t, const glm::vec3& s, glm::mat4& out)
+            {
+                out[0] = glm::vec4(c0 * s.x, 0.0f);
+                out[1] = glm::vec4(c1 * s.y, 0.0f);
+                out[2] = glm::vec4(c2 * s.z, 0.0f);
+                out[3] = glm::vec4(t,        1.0f);
+            }
+        }
+
+        Instruction_Set get_instruction_set()
+        {
+            return kernels().active;
+        }
+
+        const char* get_instruction_set_name()
+        {
+            switch (kernels().active)
+            {
+                case Instruction_Set::AVX2: return "avx2";
+                case Instruction_Set::SSE:  return "sse";
+                default:                    return "scalar";
+            }
+        }
+
+        void set_instruction_set(Instruction_Set set)
+        {
+            select(kernels(), set);
+        }
+
+        void compose_trs(const glm::vec3& t, const glm::vec3& euler_degrees, const glm::vec3& s, glm::mat4& out)
+        {
+            // Forma cerrada de Rx * Ry * Rz: un seno y un coseno por eje en lugar de tres productos 4x4
+            glm::vec3 radians = glm::radians(euler_degrees);
+
+            float sa = std::sin(radians.x), ca = std::cos(radians.x);
+            float sb = std::sin(radians.y), cb = std::cos(radians.y);
+            float sc = std::sin(radians.z), cc = std::cos(radians.z);
+
+            store_trs
+            (
+                glm::vec3( cb * cc,  sa * sb * cc + ca * sc, -ca * sb * cc + sa * sc),
+                glm::vec3(-cb * sc, -sa * sb * sc + ca * cc,  ca * sb * sc + sa * cc),
+                glm::vec3( sb,      -sa * cb,                 ca * cb               ),
+                t, s, out
+            );
+        }
+
+        void compose_trs(const glm::vec3& t, const glm::quat& q, const glm::vec3& s, glm::mat4& out)
+        {
+            glm::mat3 r = glm::mat3_cast(q);
+            store_trs(r[0], r[1], r[2], t, s, out);
+        }
+
+        void compose_trs_batch(const glm::vec3* translations, const glm::vec3* euler_degrees, const glm::vec3* scales, glm::mat4* out, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i) compose_trs(translations[i], euler_degrees[i], scales[i], out[i]);
+        }
+
+        void multiply_batch(const glm::mat4* const* parents, const glm::mat4* locals, glm::mat4* out, size_t count)
+        {
+            kernels().multiply_batch(parents, locals, out, count);
+        }
+
+        void multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+        {
+            const glm::mat4* parent = &a;
+            kernels().multiply_batch(&parent, &b, &out, 1);
+        }
+    }
+}
@@ -0,0 +1,43 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <glm.hpp>
+#include <gtc/quaternion.hpp>
+
+namespace udit
+{
+    // Núcleos de cálculo de transformaciones para el grafo de escena.
+    //
+    // Las matrices TRS se construyen directamente (sin las tres llamadas genéricas a
+    // glm::rotate) y los productos padre x local se hacen por lotes con SSE o AVX2,
+    // elegidos en tiempo de ejecución según la CPU, con una versión escalar de respaldo.
+    namespace transform_math
+    {
+        enum class Instruction_Set { SCALAR, SSE, AVX2 };
+
+        // Conjunto de instrucciones usado por los núcleos (detectado una sola vez)
+        Instruction_Set get_instruction_set();
+        const char*     get_instruction_set_name();
+
+        // Fuerza un conjunto concreto (para comparar); se limita a lo que soporte la CPU
+        void            set_instruction_set(Instruction_Set set);
+
+        // T * Rx * Ry * Rz * S con ángulos de Euler en grados (mismo orden que Node)
+        void compose_trs(const glm::vec3& translation, const glm::vec3& euler_degrees, const glm::vec3& scale, glm::mat4& out);
+
+        // T * R(q) * S
+        void compose_trs(const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale, glm::mat4& out);
+
+        // Construcción por lotes de matrices locales a partir de arrays SoA
+        void compose_trs_batch(const glm::vec3* translations, const glm::vec3* euler_degrees, const glm::vec3* scales, glm::mat4* out, size_t count);
+
+        // out[i] = *parents[i] * locals[i]. Admite que out[i] coincida con locals[i].
+        void multiply_batch(const glm::mat4* const* parents, const glm::mat4* locals, glm::mat4* out, size_t count);
+
+        // Producto individual con el núcleo activo
+        void multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out);
+    }
+}
@@ -0,0 +1,319 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#include "Transform_Store.hpp"
+#include "Trace.hpp"
+#include "Transform_Math.hpp"
+#include "Thread_Pool.hpp"
+#include <algorithm>
+#include <gtc/matrix_transform.hpp>
+
+namespace udit
+{
+    constexpr Transform_Store::Handle Transform_Store::invalid_handle;
+    constexpr uint32_t                Transform_Store::no_parent;
+    constexpr size_t                  Transform_Store::parallel_threshold;
+
+    Transform_Store::Transform_Store()
+        : needs_sort(false), pending_changes(false), dead_count(0), partition_dirty(true), parallel_enabled(true)
+    {
+    }
+
+    Transform_Store& Transform_Store::instance()
+    {
+        static Transform_Store store;
+        return store;
+    }
+
+    Transform_Store::Handle Transform_Store::create()
+    {
+        Handle handle;
+
+        if (!free_handles.empty()) {
+            handle = free_handles.back();
+            free_handles.pop_back();
+        }
+        else {
+            handle = Handle(handle_to_index.size());
+            handle_to_index.push_back(0);
+        }
+
+        // Los nodos nuevos no tienen padre: añadirlos al final mantiene el orden
+        uint32_t index = uint32_t(positions.size());
+
+        positions      .push_back(glm::vec3(0.0f));
+        rotations      .push_back(glm::vec3(0.0f));
+        scales         .push_back(glm::vec3(1.0f));
+        parents        .push_back(no_parent);
+        subtree_ends   .push_back(index + 1);
+        local_matrices .push_back(glm::mat4(1.0f));
+        world_matrices .push_back(glm::mat4(1.0f));
+        world_versions .push_back(0);
+        dirty          .push_back(1);
+        changed        .push_back(0);
+        index_to_handle.push_back(handle);
+
+        handle_to_index[handle] = index;
+        pending_changes = true;
+
+        // El reparto entre hilos aún no incluye el índice nuevo
+        partition_dirty = true;
+
+        return handle;
+    }
+
+    void Transform_Store::destroy(Handle handle)
+    {
+        uint32_t index = handle_to_index[handle];
+
+        // El hueco se compacta en la siguiente reordenación
+        index_to_handle[index]  = invalid_handle;
+        handle_to_index[handle] = no_parent;
+        free_handles.push_back(handle);
+
+        dead_count++;
+        needs_sort      = true;
+        partition_dirty = true;
+    }
+
+    void Transform_Store::set_parent(Handle child, Handle parent)
+    {
+        uint32_t child_index = handle_to_index[child];
+
+        parents[child_index] = parent == invalid_handle ? no_parent : handle_to_index[parent];
+        dirty  [child_index] = 1;
+
+        // Cambia la topología: hay que restablecer el preorden y los rangos de subárbol
+        needs_sort = true;
+    }
+
+    void Transform_Store::update()
+    {
+        UDIT_TRACE_SCOPE("Transform_Store::update");
+
+        // Sin cambios desde el último frame no hace falta ni recorrer los arrays
+        if (!needs_sort && !pending_changes) return;
+
+        if (needs_sort) sort();
+
+        Thread_Pool* pool = size() >= parallel_threshold && parallel_enabled ? &Thread_Pool::instance() : nullptr;
+
+        if (!pool || pool->get_worker_count() == 0)
+        {
+            update_range(0, uint32_t(size()));
+        }
+        else
+        {
+            if (partition_dirty) build_partition(pool->get_worker_count());
+
+            // Los ancestros van primero y en orden: cada uno solo depende de los anteriores
+            for (uint32_t index : serial_nodes) update_range(index, index + 1);
+
+            // Cada rango es un conjunto de subárboles completos cuyos padres ya están al día
+            pool->parallel_for(parallel_ranges.size(), [this] (size_t k)
+            {
+                update_range(parallel_ranges[k].first, parallel_ranges[k].second);
+            });
+        }
+
+        pending_changes = false;
+    }
+
+    void Transform_Store::update_range(uint32_t first, uint32_t last)
+    {
+        // Los productos padre x local se acumulan en lotes para los núcleos SIMD.
+        // Un lote se vacía antes de aceptar un nodo cuyo padre esté dentro de él.
+        constexpr uint32_t batch_capacity = 8;
+
+        const glm::mat4* batch_parents[batch_capacity];
+        uint32_t         batch_indices[batch_capacity];
+        glm::mat4        batch_results[batch_capacity];
+        glm::mat4        batch_locals [batch_capacity];
+        uint32_t         batch_size  = 0;
+        uint32_t         batch_first = first;
+
+        auto flush = [&] ()
+        {
+            transform_math::multiply_batch(batch_parents, batch_locals, batch_results, batch_size);
+
+            for (uint32_t k = 0; k < batch_size; ++k) world_matrices[batch_indices[k]] = batch_results[k];
+
+            batch_size = 0;
+        };
+
+        // Recorrido lineal: el padre de i siempre tiene un índice menor que i,
+        // así que su indicador de cambio ya está al día
+        for (uint32_t i = first; i < last; ++i)
+        {
+            uint32_t parent = parents[i];
+            bool parent_changed = parent != no_parent && changed[parent];
+
+            if (dirty[i]) {
+                compose_local(i);
+            }
+
+            if (dirty[i] || parent_changed) {
+                if (parent == no_parent) {
+                    world_matrices[i] = local_matrices[i];
+                }
+                else {
+                    if (batch_size == batch_capacity || (batch_size > 0 && parent >= batch_first)) flush();
+                    if (batch_size == 0) batch_first = i;
+
+                    batch_parents[batch_size] = &world_matrices[parent];
+                    batch_locals [batch_size] = local_matrices[i];
+                    batch_indices[batch_size] = i;
+                    batch_size++;
+                }
+
+                world_versions[i]++;
+                changed[i] = 1;
+            }
+            else {
+                changed[i] = 0;
+            }
+
+            dirty[i] = 0;
+        }
+
+        if (batch_size > 0) flush();
+    }
+
+    void Transform_Store::compose_local(uint32_t i)
+    {
+        // Construcción directa de la matriz local TRS (Translate, Rotate, Scale)
+        transform_math::compose_trs(positions[i], rotations[i], scales[i], local_matrices[i]);
+    }
+
+    void Transform_Store::sort()
+    {
+        UDIT_TRACE_SCOPE("Transform_Store::sort");
+
+        const uint32_t count = uint32_t(size());
+
+        auto is_alive = [this] (uint32_t i) { return index_to_handle[i] != invalid_handle; };
+
+        // Listas de hijos en formato compacto (CSR) respetando el orden actual
+        std::vector<uint32_t> child_offsets(count + 1, 0);
+        std::vector<uint32_t> roots;
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (!is_alive(i)) continue;
+
+            uint32_t parent = parents[i];
+
+            if (parent != no_parent && is_alive(parent)) child_offsets[parent + 1]++;
+            else roots.push_back(i);
+        }
+
+        for (uint32_t i = 0; i < count; ++i) child_offsets[i + 1] += child_offsets[i];
+
+        std::vector<uint32_t> child_list(child_offsets[count]);
+        std::vector<uint32_t> fill(child_offsets.begin(), child_offsets.end() - 1);
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t parent = parents[i];
+            if (is_alive(i) && parent != no_parent && is_alive(parent)) child_list[fill[parent]++] = i;
+        }
+
+        // Recorrido en preorden (iterativo) para obtener el nuevo orden
+        std::vector<uint32_t> order;
+        std::vector<uint32_t> stack;
+
+        order.reserve(count - dead_count);
+
+        for (auto root = roots.rbegin(); root != roots.rend(); ++root) stack.push_back(*root);
+
+        while (!stack.empty())
+        {
+            uint32_t i = stack.back();
+            stack.pop_back();
+            order.push_back(i);
+
+            for (uint32_t c = child_offsets[i + 1]; c > child_offsets[i]; --c) stack.push_back(child_list[c - 1]);
+        }
+
+        std::vector<uint32_t> new_index(count, no_parent);
+        for (uint32_t k = 0; k < uint32_t(order.size()); ++k) new_index[order[k]] = k;
+
+        // Permutación de todos los arrays
+        auto permute = [&order] (auto& array)
+        {
+            std::remove_reference_t<decltype(array)> sorted;
+            sorted.reserve(order.size());
+            for (uint32_t old_index : order) sorted.push_back(array[old_index]);
+            array.swap(sorted);
+        };
+
+        permute(positions);
+        permute(rotations);
+        permute(scales);
+        permute(parents);
+        permute(local_matrices);
+        permute(world_matrices);
+        permute(world_versions);
+        permute(dirty);
+        permute(changed);
+        permute(index_to_handle);
+
+        const uint32_t new_count = uint32_t(order.size());
+
+        subtree_ends.resize(new_count);
+
+        for (uint32_t k = 0; k < new_count; ++k)
+        {
+            uint32_t parent = parents[k];
+            parents[k] = parent != no_parent ? new_index[parent] : no_parent;
+            handle_to_index[index_to_handle[k]] = k;
+            subtree_ends[k] = k + 1;
+        }
+
+        // En preorden, el rango de un subárbol termina donde termina el de su último descendiente
+        for (uint32_t k = new_count; k-- > 0; )
+        {
+            if (parents[k] != no_parent) subtree_ends[parents[k]] = std::max(subtree_ends[parents[k]], subtree_ends[k]);
+        }
+
+        dead_count = 0;
+        needs_sort = false;
+        partition_dirty = true;
+    }
+
+    void Transform_Store::build_partition(unsigned worker_count)
+    {
+        serial_nodes.clear();
+        parallel_ranges.clear();
+
+        const uint32_t count = uint32_t(size());
+
+        // Unas cuatro tareas por hilo para equilibrar la carga, sin bajar de 256 nodos
+        const uint32_t grain = std::max<uint32_t>(256, count / ((worker_count + 1) * 4));
+
+        for (uint32_t i = 0; i < count; )
+        {
+            uint32_t end = subtree_ends[i];
+
+            if (end - i > grain)
+            {
+                // Subárbol demasiado grande: su raíz se procesa antes y se reparte por debajo
+                serial_nodes.push_back(i);
+                i++;
+                continue;
+            }
+
+            // Subárboles hermanos contiguos se agrupan mientras quepan en el grano
+            if (!parallel_ranges.empty() && parallel_ranges.back().second == i && end - parallel_ranges.back().first <= grain) {
+                parallel_ranges.back().second = end;
+            }
+            else {
+                parallel_ranges.emplace_back(i, end);
+            }
+
+            i = end;
+        }
+
+        partition_dirty = false;
+    }
+}
@@ -0,0 +1,102 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <glm.hpp>
+
+namespace udit
+{
+    // Almacén orientado a datos de las transformaciones de la escena.
+    //
+    // Los TRS locales, los índices de padre y las matrices se guardan en arrays
+    // contiguos (SoA) ordenados en preorden: cada padre precede a sus hijos y cada
+    // subárbol ocupa un rango contiguo. La propagación de matrices globales es un
+    // único recorrido lineal. Los nodos guardan un Handle estable, ya que los índices
+    // cambian cuando se reordena el almacén.
+    class Transform_Store
+    {
+    public:
+
+        using Handle = uint32_t;
+
+        static constexpr Handle   invalid_handle = ~Handle(0);
+        static constexpr uint32_t no_parent      = ~uint32_t(0);
+
+        // Por debajo de este número de nodos la actualización es siempre secuencial
+        static constexpr size_t   parallel_threshold = 4096;
+
+    private:
+
+        // Datos por índice (orden topológico)
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> rotations;           // Euler en grados (X, Y, Z)
+        std::vector<glm::vec3> scales;
+        std::vector<uint32_t>  parents;             // Índice del padre o no_parent
+        std::vector<uint32_t>  subtree_ends;        // Índice siguiente al último descendiente
+        std::vector<glm::mat4> local_matrices;
+        std::vector<glm::mat4> world_matrices;
+        std::vector<uint32_t>  world_versions;
+        std::vector<uint8_t>   dirty;               // TRS local modificado
+        std::vector<uint8_t>   changed;             // Matriz global recalculada en este update
+        std::vector<Handle>    index_to_handle;
+
+        // Indirección estable de handles
+        std::vector<uint32_t>  handle_to_index;
+        std::vector<Handle>    free_handles;
+
+        bool                   needs_sort;
+        bool                   pending_changes;     // Algún TRS modificado desde el último update
+        size_t                 dead_count;
+
+        // Reparto para la actualización en paralelo: primero los ancestros de subárboles
+        // grandes (en orden), después rangos de subárboles independientes en los hilos
+        std::vector<uint32_t>                       serial_nodes;
+        std::vector<std::pair<uint32_t, uint32_t>>  parallel_ranges;
+        bool                                        partition_dirty;
+        bool                                        parallel_enabled;
+
+    public:
+
+        Transform_Store();
+
+        // Almacén compartido por todos los nodos de la escena
+        static Transform_Store& instance();
+
+        Handle create();
+        void   destroy(Handle handle);
+        void   set_parent(Handle child, Handle parent);
+
+        // Reordena (si hace falta) y propaga las matrices globales en un solo recorrido
+        void   update();
+
+        size_t size() const { return positions.size(); }
+
+        // Permite forzar la ruta secuencial (las matrices resultantes son idénticas)
+        void set_parallel_enabled(bool value) { parallel_enabled = value; }
+
+    public:
+
+        const glm::vec3& get_position(Handle h) const { return positions[handle_to_index[h]]; }
+        const glm::vec3& get_rotation(Handle h) const { return rotations[handle_to_index[h]]; }
+        const glm::vec3& get_scale   (Handle h) const { return scales   [handle_to_index[h]]; }
+
+        void set_position(Handle h, const glm::vec3& value) { uint32_t i = handle_to_index[h]; positions[i] = value; dirty[i] = 1; pending_changes = true; }
+        void set_rotation(Handle h, const glm::vec3& value) { uint32_t i = handle_to_index[h]; rotations[i] = value; dirty[i] = 1; pending_changes = true; }
+        void set_scale   (Handle h, const glm::vec3& value) { uint32_t i = handle_to_index[h]; scales   [i] = value; dirty[i] = 1; pending_changes = true; }
+
+        const glm::mat4& get_local_matrix(Handle h) const { return local_matrices[handle_to_index[h]]; }
+        const glm::mat4& get_world_matrix(Handle h) const { return world_matrices[handle_to_index[h]]; }
+        uint32_t         get_world_version(Handle h) const { return world_versions[handle_to_index[h]]; }
+
+    private:
+
+        void sort();
+        void update_range(uint32_t first, uint32_t last);
+        void build_partition(unsigned worker_count);
+        void compose_local(uint32_t index);
+    };
+}
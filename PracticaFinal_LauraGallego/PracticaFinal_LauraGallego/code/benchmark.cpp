@@ -0,0 +1,604 @@
+// Este código es de dominio público
+// penterrin@gmail.com
+
+// Benchmark sin ventana: carga assets/scene.txt a través de Scene, recorre un camino
+// de cámara determinista durante N frames (sin vsync) y vuelca los tiempos en JSON.
+//
+// Uso (desde la carpeta Binaries):  benchmark [frames] [salida.json] [--oit] [--no-prepass]
+//                                   benchmark --transforms [nodos]
+//
+// Las opciones pueden ir en cualquier posición.
+//
+// El modo --transforms no necesita contexto OpenGL: compara la composición TRS y el
+// producto padre x local de glm con los núcleos de Transform_Math.
+//
+// Con --oit las mallas transparentes se dibujan con weighted blended OIT en lugar de
+// ordenadas de lejos a cerca, para comparar el coste de ambos caminos. Con --no-prepass
+// se desactiva el pre-pase de profundidad; shaded_fragments_mean mide su efecto.
+//
+// En Linux se crea un contexto OpenGL 3.3 core sin superficie mediante EGL
+// (plataforma surfaceless de Mesa, vale llvmpipe). Compilación de referencia, desde la
+// carpeta que contiene code/ (los asserts se desactivan para medir en release):
+//
+//   gcc -O2 -c ../Libraries/glad/src/gl.c -I../Libraries/glad/include -o glad.o
+//
+//   g++ -std=c++14 -O2 -DNDEBUG -pthread code/benchmark.cpp code/Scene.cpp code/Node.cpp
+//       code/Transform_Store.cpp code/Transform_Math.cpp code/Thread_Pool.cpp
+//       code/Trace.cpp code/Gpu_Profiler.cpp code/Sample_Counter.cpp code/Frustum.cpp
+//       code/Asset_Loader.cpp code/Resource_Cache.cpp code/Geometry.cpp
+//       code/Geometry_Buffer.cpp code/Range_Allocator.cpp code/Mesh_Cache.cpp
+//       code/Mesh_Optimizer.cpp code/Mesh_Simplifier.cpp code/Mesh.cpp
+//       code/Instanced_Renderer.cpp code/Render_Queue.cpp code/Frame_Uniforms.cpp
+//       code/Terrain.cpp code/Heightfield.cpp code/Skybox.cpp code/Texture_Cube.cpp
+//       code/Light.cpp glad.o
+//       -I../shared/code -I../Libraries/{sdl3,glad,glm,soil2,assimp,half}/include
+//       -lEGL -lsoil2 -lassimp -lSDL3 -o ../Binaries/benchmark
+//
+// Libraries/glad solo trae la cabecera; gl.c es el cargador que la acompaña y se genera
+// con glad 2.0.8 y los parámetros que figuran en ella
+// (--api='gl:compatibility=3.3' --extensions='' c --loader).
+//
+// En el resto de plataformas se usa una ventana SDL normal con el vsync desactivado.
+
+#include "Scene.hpp"
+#include "Asset_Loader.hpp"
+#include "Trace.hpp"
+#include "Transform_Math.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+    #include <EGL/egl.h>
+    #include <EGL/eglext.h>
+#else
+    #include <Window.hpp>
+#endif
+
+using udit::Asset_Loader;
+using udit::Scene;
+
+namespace
+{
+
+    constexpr unsigned viewport_width  = 1024;
+    constexpr unsigned viewport_height = 576;
+    constexpr float    frame_step      = 1.f / 60.f;        // Paso de simulación fijo
+
+    // Puntos de control del recorrido de cámara (posición y objetivo), cerrado en bucle
+
+    struct Camera_Key
+    {
+        glm::vec3 location;
+        glm::vec3 target;
+    };
+
+    const Camera_Key camera_path[] =
+    {
+        { {   0.f, 10.f,  15.f }, {  0.f, 6.f,  0.f } },
+        { {  18.f, 12.f,  10.f }, {  2.f, 6.f,  0.f } },
+        { {  22.f,  6.f, -12.f }, {  0.f, 4.f,  0.f } },
+        { {   0.f, 16.f, -22.f }, { -2.f, 6.f,  0.f } },
+        { { -20.f,  8.f, -10.f }, {  0.f, 2.f,  5.f } },
+        { { -15.f,  4.f,  14.f }, {  4.f, 8.f,  0.f } },
+    };
+
+    constexpr size_t camera_path_size = sizeof(camera_path) / sizeof(camera_path[0]);
+
+    // Interpolación Catmull-Rom uniforme entre p1 y p2
+
+    glm::vec3 catmull_rom (const glm::vec3 & p0, const glm::vec3 & p1, const glm::vec3 & p2, const glm::vec3 & p3, float t)
+    {
+        float t2 = t  * t;
+        float t3 = t2 * t;
+
+        return 0.5f *
+        (
+            (2.f * p1) +
+            (-p0 + p2) * t +
+            (2.f * p0 - 5.f * p1 + 4.f * p2 - p3) * t2 +
+            (-p0 + 3.f * p1 - 3.f * p2 + p3) * t3
+        );
+    }
+
+    // Evalúa el recorrido en t [0, 1) y coloca la cámara de la escena
+
+    void place_camera (udit::Camera & camera, float t)
+    {
+        float  position = t * camera_path_size;
+        size_t segment  = size_t(position) % camera_path_size;
+        float  local_t  = position - std::floor (position);
+
+        auto key = [segment] (int offset) -> const Camera_Key &
+        {
+            return camera_path[(segment + camera_path_size + offset) % camera_path_size];
+        };
+
+        glm::vec3 location = catmull_rom (key (-1).location, key (0).location, key (1).location, key (2).location, local_t);
+        glm::vec3 target   = catmull_rom (key (-1).target,   key (0).target,   key (1).target,   key (2).target,   local_t);
+
+        camera.set_location (location.x, location.y, location.z);
+        camera.set_target   (target.x,   target.y,   target.z  );
+    }
+
+    struct Statistics
+    {
+        double mean;
+        double p50;
+        double p95;
+        double p99;
+    };
+
+    Statistics compute_statistics (std::vector< double > samples)
+    {
+        Statistics statistics{ 0, 0, 0, 0 };
+
+        if (samples.empty ()) return statistics;
+
+        std::sort (samples.begin (), samples.end ());
+
+        double sum = 0;
+        for (double sample : samples) sum += sample;
+
+        // Percentil por rango más cercano
+
+        auto percentile = [&samples] (double p)
+        {
+            size_t rank = size_t(std::ceil (p / 100.0 * samples.size ()));
+            return samples[std::min (std::max< size_t > (rank, 1), samples.size ()) - 1];
+        };
+
+        statistics.mean = sum / samples.size ();
+        statistics.p50  = percentile (50);
+        statistics.p95  = percentile (95);
+        statistics.p99  = percentile (99);
+
+        return statistics;
+    }
+
+    void write_statistics (std::ostream & out, const char * name, const Statistics & statistics)
+    {
+        out << "  \"" << name << "\": { "
+            << "\"mean\": " << statistics.mean << ", "
+            << "\"p50\": "  << statistics.p50  << ", "
+            << "\"p95\": "  << statistics.p95  << ", "
+            << "\"p99\": "  << statistics.p99  << " }";
+    }
+
+    // Entero positivo; false si el texto no es un número completo
+
+    bool parse_count (const char * text, unsigned long & value)
+    {
+        try
+        {
+            size_t length = 0;
+            value = std::stoul (text, &length);
+            return text[0] != '-' && length == std::strlen (text) && value > 0;
+        }
+        catch (const std::logic_error &)
+        {
+            return false;
+        }
+    }
+
+    int print_usage (const char * program)
+    {
+        std::cerr << "Uso: " << program << " [frames] [salida.json] [--oit] [--no-prepass]\n"
+                  << "     " << program << " --transforms [nodos]" << std::endl;
+        return 1;
+    }
+
+    // Scene y los importadores escriben sus mensajes en std::cout; mientras existe se
+    // desvían a std::cerr para que la salida estándar solo lleve el JSON
+
+    class Log_Redirect
+    {
+        std::streambuf * standard_output;
+
+    public:
+
+        Log_Redirect() : standard_output(std::cout.rdbuf (std::cerr.rdbuf ()))
+        {
+        }
+
+       ~Log_Redirect()
+        {
+            std::cout.rdbuf (standard_output);
+        }
+
+        std::streambuf * get_standard_output () const { return standard_output; }
+    };
+
+    // Cadena lista para ir entre comillas en el JSON
+
+    std::string escape_json (const char * text)
+    {
+        std::string escaped;
+
+        for (const char * c = text ? text : ""; *c; ++c)
+        {
+            if (*c == '"' || *c == '\\') escaped += '\\';
+
+            if (static_cast< unsigned char >(*c) < 0x20) escaped += ' ';
+            else                                         escaped += *c;
+        }
+
+        return escaped;
+    }
+
+    // Microbenchmark de transformaciones: glm genérico frente a Transform_Math
+
+    int run_transform_benchmark (size_t node_count)
+    {
+        using Clock = std::chrono::steady_clock;
+        namespace tm = udit::transform_math;
+
+        std::mt19937 random(1234);
+        std::uniform_real_distribution< float > position_range(-50.f,  50.f);
+        std::uniform_real_distribution< float > angle_range   (-180.f, 180.f);
+        std::uniform_real_distribution< float > scale_range   (0.5f,   2.f);
+
+        std::vector< glm::vec3 > positions(node_count), rotations(node_count), scales(node_count);
+        std::vector< size_t    > parents  (node_count);
+
+        for (size_t i = 0; i < node_count; ++i)
+        {
+            positions[i] = { position_range (random), position_range (random), position_range (random) };
+            rotations[i] = { angle_range    (random), angle_range    (random), angle_range    (random) };
+            scales   [i] = { scale_range    (random), scale_range    (random), scale_range    (random) };
+            parents  [i] = i ? (i - 1) / 8 : 0;         // Jerarquía ancha: 8 hijos por nodo
+        }
+
+        std::vector< glm::mat4 > locals(node_count), worlds(node_count), reference(node_count);
+        std::vector< const glm::mat4 * > parent_pointers(node_count);
+
+        for (size_t i = 0; i < node_count; ++i) parent_pointers[i] = &worlds[parents[i]];
+
+        constexpr int repetitions = 20;
+
+        auto measure = [&] (auto && body)
+        {
+            double best = 1e30;
+
+            for (int r = 0; r < repetitions; ++r)
+            {
+                auto start = Clock::now ();
+                body ();
+                best = std::min (best, std::chrono::duration< double, std::nano >(Clock::now () - start).count ());
+            }
+
+            return best / node_count;
+        };
+
+        // Ruta original de Node::update: translate + 3 x rotate + scale y producto glm
+
+        double glm_ns = measure ([&]
+        {
+            for (size_t i = 0; i < node_count; ++i)
+            {
+                glm::mat4 m = glm::translate (glm::mat4(1.f), positions[i]);
+                m = glm::rotate (m, glm::radians (rotations[i].x), glm::vec3(1, 0, 0));
+                m = glm::rotate (m, glm::radians (rotations[i].y), glm::vec3(0, 1, 0));
+                m = glm::rotate (m, glm::radians (rotations[i].z), glm::vec3(0, 0, 1));
+                m = glm::scale  (m, scales[i]);
+
+                reference[i] = i == 0 ? m : reference[parents[i]] * m;
+            }
+        });
+
+        std::ostringstream json;
+
+        json << "{\n  \"nodes\": " << node_count << ",\n  \"glm_ns_per_node\": " << glm_ns;
+
+        const tm::Instruction_Set sets[] = { tm::Instruction_Set::SCALAR, tm::Instruction_Set::SSE, tm::Instruction_Set::AVX2 };
+
+        for (tm::Instruction_Set set : sets)
+        {
+            tm::set_instruction_set (set);
+            if (tm::get_instruction_set () != set) continue;
+
+            // Los padres siempre preceden a sus hijos: se procesa por lotes de 8 sin dependencias internas
+            double kernel_ns = measure ([&]
+            {
+                tm::compose_trs_batch (positions.data (), rotations.data (), scales.data (), locals.data (), node_count);
+
+                worlds[0] = locals[0];
+
+                for (size_t first = 1; first < node_count; first += 8)
+                {
+                    size_t count = std::min< size_t > (8, node_count - first);
+                    tm::multiply_batch (parent_pointers.data () + first, locals.data () + first, worlds.data () + first, count);
+                }
+            });
+
+            double max_error = 0;
+
+            for (size_t i = 0; i < node_count; ++i)
+                for (int c = 0; c < 4; ++c)
+                    for (int r = 0; r < 4; ++r)
+                        max_error = std::max (max_error, double(std::abs (worlds[i][c][r] - reference[i][c][r]) / (1.f + std::abs (reference[i][c][r]))));
+
+            json << ",\n  \"" << tm::get_instruction_set_name () << "_ns_per_node\": " << kernel_ns
+                 << ",\n  \""  << tm::get_instruction_set_name () << "_max_relative_error\": " << max_error;
+        }
+
+        json << "\n}\n";
+
+        std::cout << json.str ();
+
+        return 0;
+    }
+
+    #if defined(__linux__)
+
+        // Contexto OpenGL 3.3 core sin superficie (EGL_MESA_platform_surfaceless / EGL_KHR_surfaceless_context)
+
+        class Headless_Context
+        {
+            EGLDisplay display = EGL_NO_DISPLAY;
+            EGLContext context = EGL_NO_CONTEXT;
+
+        public:
+
+            Headless_Context()
+            {
+                // La plataforma surfaceless se pide explícitamente; si el driver no la
+                // ofrece, se usa la pantalla por defecto (que respeta EGL_PLATFORM)
+
+                auto get_platform_display = reinterpret_cast< PFNEGLGETPLATFORMDISPLAYEXTPROC >(eglGetProcAddress ("eglGetPlatformDisplayEXT"));
+
+                bool initialized = false;
+
+                if (get_platform_display)
+                {
+                    display     = get_platform_display (EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+                    initialized = display != EGL_NO_DISPLAY && eglInitialize (display, nullptr, nullptr);
+                }
+
+                if (!initialized)
+                {
+                    display     = eglGetDisplay (EGL_DEFAULT_DISPLAY);
+                    initialized = display != EGL_NO_DISPLAY && eglInitialize (display, nullptr, nullptr);
+                }
+
+                if (!initialized)
+                {
+                    throw "Failed to initialize EGL.";
+                }
+
+                const EGLint config_attributes[] =
+                {
+                    EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+                    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                    EGL_NONE
+                };
+
+                EGLConfig config;
+                EGLint    config_count = 0;
+
+                eglChooseConfig (display, config_attributes, &config, 1, &config_count);
+                eglBindAPI      (EGL_OPENGL_API);
+
+                const EGLint context_attributes[] =
+                {
+                    EGL_CONTEXT_MAJOR_VERSION,       3,
+                    EGL_CONTEXT_MINOR_VERSION,       3,
+                    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                    EGL_NONE
+                };
+
+                context = eglCreateContext (display, config_count ? config : EGLConfig(nullptr), EGL_NO_CONTEXT, context_attributes);
+
+                if (context == EGL_NO_CONTEXT || !eglMakeCurrent (display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+                {
+                    throw "Failed to create a surfaceless OpenGL 3.3 context.";
+                }
+
+                if (!gladLoadGL (reinterpret_cast< GLADloadfunc >(eglGetProcAddress)))
+                {
+                    throw "Failed to load OpenGL functions.";
+                }
+            }
+
+           ~Headless_Context()
+            {
+                eglMakeCurrent    (display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+                eglDestroyContext (display, context);
+                eglTerminate      (display);
+            }
+        };
+
+    #endif
+
+}
+
+int main (int argc, char * argv[])
+{
+    // Las opciones pueden ir en cualquier posición; el resto son [frames] [salida.json]
+    // (o [nodos] con --transforms)
+
+    std::vector< const char * > positional;
+
+    bool transforms = false;
+    bool oit        = false;
+    bool prepass    = true;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if      (std::strcmp  (argv[i], "--transforms") == 0) transforms = true;
+        else if (std::strcmp  (argv[i], "--oit"       ) == 0) oit        = true;
+        else if (std::strcmp  (argv[i], "--no-prepass") == 0) prepass    = false;
+        else if (std::strncmp (argv[i], "--", 2       ) == 0) return print_usage (argv[0]);
+        else positional.push_back (argv[i]);
+    }
+
+    unsigned long count = 0;
+
+    if (!positional.empty () && !parse_count (positional[0], count)) return print_usage (argv[0]);
+
+    if (transforms)
+    {
+        if (positional.size () > 1) return print_usage (argv[0]);
+
+        return run_transform_benchmark (positional.empty () ? 100000 : size_t(count));
+    }
+
+    if (positional.size () > 2) return print_usage (argv[0]);
+
+    unsigned    frame_count = positional.empty ()    ? 1000 : unsigned(count);
+    std::string output_path = positional.size () > 1 ? positional[1] : "";
+
+    Log_Redirect log_redirect;
+
+    try
+    {
+        #if defined(__linux__)
+            Headless_Context context;
+        #else
+            udit::Window::OpenGL_Context_Settings settings;
+            settings.enable_vsync = false;
+            udit::Window window("Benchmark", viewport_width, viewport_height, settings);
+        #endif
+
+        // Sin ventana no hay framebuffer por defecto: el post-proceso se resuelve en uno propio
+
+        GLuint output_framebuffer, output_colorbuffer;
+
+        glGenFramebuffers  (1, &output_framebuffer);
+        glGenRenderbuffers (1, &output_colorbuffer);
+        glBindRenderbuffer (GL_RENDERBUFFER, output_colorbuffer);
+        glRenderbufferStorage (GL_RENDERBUFFER, GL_RGBA8, viewport_width, viewport_height);
+        glBindFramebuffer  (GL_FRAMEBUFFER, output_framebuffer);
+        glFramebufferRenderbuffer (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, output_colorbuffer);
+        glBindFramebuffer  (GL_FRAMEBUFFER, 0);
+
+        glViewport (0, 0, viewport_width, viewport_height);
+
+        // Tiempo hasta tener todos los recursos en la GPU (la carga es asíncrona)
+
+        auto load_start = std::chrono::steady_clock::now ();
+
+        Scene scene(viewport_width, viewport_height);
+
+        Asset_Loader::instance ().wait_all ();
+
+        double load_ms = std::chrono::duration< double, std::milli >(std::chrono::steady_clock::now () - load_start).count ();
+
+        scene.set_output_framebuffer (output_framebuffer);
+        scene.set_oit_enabled (oit);
+        scene.set_depth_prepass_enabled (prepass);
+
+        // Sin teclas pulsadas: el único movimiento es el del recorrido y las animaciones
+
+        bool no_keys[SDL_SCANCODE_COUNT] = {};
+
+        std::vector< double > cpu_times;
+        std::vector< double > frame_times;
+
+        cpu_times  .reserve (frame_count);
+        frame_times.reserve (frame_count);
+
+        double visible_total = 0.0;
+        double culled_total  = 0.0;
+        double triangle_total = 0.0;
+        double state_change_total = 0.0;
+        double shaded_total = 0.0;
+        double terrain_triangle_total = 0.0;
+
+        using Clock = std::chrono::steady_clock;
+
+        // Un frame de calentamiento para que la compilación de shaders no cuente
+
+        scene.update (frame_step, no_keys);
+        scene.render ();
+        glFinish ();
+
+        for (unsigned frame = 0; frame < frame_count; ++frame)
+        {
+            auto frame_start = Clock::now ();
+
+            place_camera (scene.get_camera (), float(frame) / frame_count);
+
+            scene.update (frame_step, no_keys);
+            scene.render ();
+
+            auto cpu_end = Clock::now ();
+
+            visible_total += double(scene.get_visible_count ());
+            culled_total  += double(scene.get_culled_count  ());
+            triangle_total += double(scene.get_mesh_triangle_count());
+            state_change_total += double(scene.get_state_changes());
+            shaded_total += double(scene.get_shaded_samples());
+            terrain_triangle_total += double(scene.get_terrain_triangle_count());
+
+            glFinish ();
+
+            auto frame_end = Clock::now ();
+
+            cpu_times  .push_back (std::chrono::duration< double, std::milli >(cpu_end   - frame_start).count ());
+            frame_times.push_back (std::chrono::duration< double, std::milli >(frame_end - frame_start).count ());
+        }
+
+        glDeleteFramebuffers  (1, &output_framebuffer);
+        glDeleteRenderbuffers (1, &output_colorbuffer);
+
+        // Volcado de resultados
+
+        Statistics cpu   = compute_statistics (cpu_times  );
+        Statistics frame = compute_statistics (frame_times);
+
+        std::ostringstream json;
+
+        json << "{\n";
+        json << "  \"frames\": " << frame_count << ",\n";
+        json << "  \"width\": "  << viewport_width  << ",\n";
+        json << "  \"height\": " << viewport_height << ",\n";
+        json << "  \"renderer\": \"" << escape_json (reinterpret_cast< const char * >(glGetString (GL_RENDERER))) << "\",\n";
+        json << "  \"transparency\": \"" << (oit ? "oit" : "sorted") << "\",\n";
+        json << "  \"depth_prepass\": " << (prepass ? "true" : "false") << ",\n";
+        write_statistics (json, "cpu_ms",   cpu  ); json << ",\n";
+        write_statistics (json, "frame_ms", frame); json << ",\n";
+        json << "  \"load_ms\": " << load_ms << ",\n";
+        json << "  \"visible_mean\": " << (frame_count ? visible_total / frame_count : 0.0) << ",\n";
+        json << "  \"culled_mean\": "  << (frame_count ? culled_total  / frame_count : 0.0) << ",\n";
+        json << "  \"mesh_triangles_mean\": " << (frame_count ? triangle_total / frame_count : 0.0) << ",\n";
+        json << "  \"terrain_triangles_mean\": " << (frame_count ? terrain_triangle_total / frame_count : 0.0) << ",\n";
+        json << "  \"state_changes_mean\": " << (frame_count ? state_change_total / frame_count : 0.0) << ",\n";
+        json << "  \"shaded_fragments_mean\": " << (frame_count ? shaded_total / frame_count : 0.0) << ",\n";
+        json << "  \"fps\": " << (frame.mean > 0 ? 1000.0 / frame.mean : 0.0) << ",\n";
+        json << "  \"per_frame\": [";
+
+        for (size_t i = 0; i < frame_times.size (); ++i)
+        {
+            json << (i ? ", " : "") << "[" << cpu_times[i] << ", " << frame_times[i] << "]";
+        }
+
+        json << "]\n}\n";
+
+        if (output_path.empty ())
+        {
+            std::ostream (log_redirect.get_standard_output ()) << json.str ();
+        }
+        else
+        {
+            std::ofstream (output_path) << json.str ();
+        }
+
+        UDIT_TRACE_FLUSH("benchmark-trace.json");
+    }
+    catch (const char * error)
+    {
+        std::cerr << "ERROR: " << error << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -2,9 +2,12 @@
 // penterrin@gmail.com
 
 #include "Scene.hpp"
+#include "Trace.hpp"
 #include <Window.hpp>
 #include <SDL3/SDL_main.h>
 #include <SDL3/SDL.h> 
+#include <chrono>
+#include <iostream>
 
 using udit::Scene;
 using udit::Window;
@@ -14,7 +17,8 @@ int main(int, char* [])
     constexpr unsigned viewport_width = 1024;
     constexpr unsigned viewport_height = 576;
 
-    
+    auto start_time = std::chrono::steady_clock::now();
+
     Window window("Practica Final - Motor Grafico", viewport_width, viewport_height, { 3, 3 });
     Scene  scene(viewport_width, viewport_height);
 
@@ -25,6 +29,7 @@ int main(int, char* [])
 
     
     Uint64 last_time = SDL_GetTicks();
+    bool   first_frame = true;
 
     do
     {
@@ -97,8 +102,17 @@ int main(int, char* [])
 
         
         window.swap_buffers();
+
+        // Los recursos se cargan en segundo plano: el primer frame ya no espera por ellos
+        if (first_frame) {
+            std::cout << "Primer frame: " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count() << " ms" << std::endl;
+            first_frame = false;
+        }
     } while (not exit);
 
+    // Volcado de las trazas de CPU (solo si se compila con UDIT_TRACE_ENABLED)
+    UDIT_TRACE_FLUSH("trace.json");
+
     SDL_Quit();
 
     return 0;
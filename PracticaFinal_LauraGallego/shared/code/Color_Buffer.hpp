@@ -1,5 +1,5 @@
 
-// Este cdigo es de dominio pblico
+// Este código es de dominio público
 // penterrin@gmail.com
 
 #pragma once
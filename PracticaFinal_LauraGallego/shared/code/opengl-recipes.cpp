@@ -1,5 +1,5 @@
 
-// Este cdigo es de dominio pblico
+// Este código es de dominio público
 // angel.rodriguez@udit.es
 
 #include "opengl-recipes.hpp"
@@ -20,7 +20,7 @@ namespace udit
         GLuint   vertex_shader_id = glCreateShader (GL_VERTEX_SHADER  );
         GLuint fragment_shader_id = glCreateShader (GL_FRAGMENT_SHADER);
 
-        // Se carga el cdigo de los shaders:
+        // Se carga el código de los shaders:
 
         const char *   vertex_shaders_code[] = {          vertex_shader_code.c_str () };
         const char * fragment_shaders_code[] = {        fragment_shader_code.c_str () };
@@ -35,7 +35,7 @@ namespace udit
         glCompileShader (  vertex_shader_id);
         glCompileShader (fragment_shader_id);
 
-        // Se comprueba que si la compilacin ha tenido xito:
+        // Se comprueba que si la compilación ha tenido éxito:
 
         glGetShaderiv   (  vertex_shader_id, GL_COMPILE_STATUS, &succeeded);
         if (!succeeded) show_compilation_error (  vertex_shader_id);
@@ -56,7 +56,7 @@ namespace udit
 
         glLinkProgram   (program_id);
 
-        // Se comprueba si el linkage ha tenido xito:
+        // Se comprueba si el linkage ha tenido éxito:
 
         glGetProgramiv  (program_id, GL_LINK_STATUS, &succeeded);
         if (!succeeded) show_linkage_error (program_id);
@@ -1,5 +1,5 @@
 
-// Este cdigo es de dominio pblico
+// Este código es de dominio público
 // angel.rodriguez@udit.es
 
 #pragma once
@@ -53,7 +53,7 @@ namespace udit
                 reinterpret_cast< uint8_t * >(image->colors ())
             );
 
-            // Se libera la memoria que reserv SOIL2 para cargar la imagen:
+            // Se libera la memoria que reservó SOIL2 para cargar la imagen:
 
             SOIL_free_image_data (loaded_pixels);
 